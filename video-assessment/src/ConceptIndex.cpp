@@ -0,0 +1,93 @@
+#include "ConceptIndex.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+ConceptIndex::ConceptIndex() : count(0)
+{
+}
+
+void ConceptIndex::resize(size_t rows)
+{
+	count = rows;
+	postings.clear();
+}
+
+void ConceptIndex::add(size_t row, int concept)
+{
+	vector<int> &list = postings[concept];
+	if (list.empty() || list.back() != (int)row) {		//Same concept twice in a file counts once
+		list.push_back((int)row);
+	}
+}
+
+size_t ConceptIndex::rows() const
+{
+	return count;
+}
+
+vector<int> ConceptIndex::parse(const string &keywords)
+{
+	vector<int> concepts;
+	stringstream ss(keywords);
+	string item;
+	while (getline(ss, item, ',')) {
+		const char *begin = item.c_str();
+		char *end;
+		long value = strtol(begin, &end, 10);
+		while (*end == ' ' || *end == '\t') end++;
+		if (end == begin || *end != '\0') {
+			if (item.find_first_not_of(" \t") != string::npos) {
+				cout << " [!] not a concept ID: " << item << endl;
+			}
+			continue;
+		}
+		concepts.push_back((int)value);
+	}
+	return concepts;
+}
+
+void ConceptIndex::matchAny(const vector<int> &concepts, vector<uint64_t> &words) const
+{
+	words.assign((count + 63) / 64, 0);
+	for (int concept : concepts) {
+		auto it = postings.find(concept);
+		if (it == postings.end()) {
+			continue;
+		}
+		for (int row : it->second) {
+			words[row / 64] |= 1ull << (row % 64);
+		}
+	}
+}
+
+//Rows of the shortest list that every other list also has
+void ConceptIndex::matchAll(const vector<int> &concepts, vector<uint64_t> &words) const
+{
+	words.assign((count + 63) / 64, 0);
+	vector<const vector<int> *> lists;
+	for (int concept : concepts) {
+		auto it = postings.find(concept);
+		if (it == postings.end()) {
+			return;								//Nobody has it
+		}
+		lists.push_back(&it->second);
+	}
+	if (lists.empty()) {
+		return;
+	}
+	sort(lists.begin(), lists.end(), [](const vector<int> *a, const vector<int> *b) { return a->size() < b->size(); });
+	for (int row : *lists[0]) {
+		bool all = true;
+		for (size_t l = 1; l < lists.size() && all; ++l) {
+			all = binary_search(lists[l]->begin(), lists[l]->end(), row);
+		}
+		if (all) {
+			words[row / 64] |= 1ull << (row % 64);
+		}
+	}
+}
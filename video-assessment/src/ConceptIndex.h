@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//Which files carry each semantic concept ID (the top 5 GoogLeNet classes of a
+//file), as ascending row lists. Keyword queries become bitsets in the layout of
+//FilterTable::visibleWords, built from the lists of the queried IDs only.
+class ConceptIndex
+{
+public:
+	ConceptIndex();
+
+	void resize(size_t rows);					//Empty lists
+	void add(size_t row, int concept);			//Rows in ascending order
+	size_t rows() const;
+
+	static std::vector<int> parse(const std::string &keywords);	//"12, 407" -> {12, 407}, bad items skipped
+
+	void matchAny(const std::vector<int> &concepts, std::vector<uint64_t> &words) const;	//Rows with at least one
+	void matchAll(const std::vector<int> &concepts, std::vector<uint64_t> &words) const;	//Rows with every one
+
+private:
+	size_t count;
+	std::unordered_map<int, std::vector<int> > postings;
+};
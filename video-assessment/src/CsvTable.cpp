@@ -0,0 +1,258 @@
+#include "CsvTable.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+	//Powers of ten that are exact in a double
+	const double exactPowers[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	//Cells of a block of lines, parsed by one task
+	struct Chunk
+	{
+		const char *begin;
+		const char *end;
+		vector<double> values;
+		vector<uint32_t> rowCells;
+		int invalid;
+	};
+
+	void parseLines(Chunk &chunk)
+	{
+		const char *p = chunk.begin;
+		chunk.invalid = 0;
+		while (p < chunk.end) {
+			const char *eol = (const char *)memchr(p, '\n', chunk.end - p);
+			if (eol == nullptr) eol = chunk.end;
+			const char *lineEnd = eol;
+			if (lineEnd > p && lineEnd[-1] == '\r') lineEnd--;
+
+			if (lineEnd > p) {					//Skip empty lines
+				uint32_t count = 0;
+				const char *cell = p;
+				for (;;) {
+					const char *comma = (const char *)memchr(cell, ',', lineEnd - cell);
+					const char *cellEnd = comma == nullptr ? lineEnd : comma;
+					double v;
+					if (!CsvTable::parseNumber(cell, cellEnd, v)) {
+						v = 0;
+						chunk.invalid++;
+					}
+					chunk.values.push_back(v);
+					count++;
+					if (comma == nullptr) break;
+					cell = comma + 1;
+				}
+				chunk.rowCells.push_back(count);
+			}
+			p = eol + 1;
+		}
+	}
+}
+
+CsvTable::CsvTable()
+{
+	clear();
+}
+
+bool CsvTable::load(const string &path, ThreadPool *pool)
+{
+	clear();
+	MappedFile file;
+	if (!file.open(path)) {
+		return false;
+	}
+	return parse(file.data(), file.size(), pool);
+}
+
+bool CsvTable::parse(const char *text, size_t length, ThreadPool *pool)
+{
+	clear();
+
+	//Cut the text in blocks at line ends, one block per worker
+	size_t blocks = (pool != nullptr && length > 64 * 1024) ? pool->size() : 1;
+	vector<Chunk> chunks;
+	const char *end = text + length;
+	const char *p = text;
+	for (size_t b = 0; b < blocks && p < end; ++b) {
+		const char *blockEnd = (b == blocks - 1) ? end : p + (end - p) / (blocks - b);
+		if (blockEnd < end) {
+			const char *eol = (const char *)memchr(blockEnd, '\n', end - blockEnd);
+			blockEnd = eol == nullptr ? end : eol + 1;
+		}
+		Chunk chunk;
+		chunk.begin = p;
+		chunk.end = blockEnd;
+		chunk.invalid = 0;
+		chunks.push_back(chunk);
+		p = blockEnd;
+	}
+
+	if (chunks.size() > 1) {
+		pool->parallelFor(chunks.size(), [&chunks](size_t c) { parseLines(chunks[c]); });
+	}
+	else if (chunks.size() == 1) {
+		parseLines(chunks[0]);
+	}
+
+	size_t totalCells = 0;
+	size_t totalRows = 0;
+	for (size_t c = 0; c < chunks.size(); ++c) {
+		totalCells += chunks[c].values.size();
+		totalRows += chunks[c].rowCells.size();
+	}
+	values.reserve(totalCells);
+	rowStart.reserve(totalRows + 1);
+	for (size_t c = 0; c < chunks.size(); ++c) {
+		values.insert(values.end(), chunks[c].values.begin(), chunks[c].values.end());
+		for (size_t r = 0; r < chunks[c].rowCells.size(); ++r) {
+			rowStart.push_back(rowStart.back() + chunks[c].rowCells[r]);
+		}
+		invalidCells += chunks[c].invalid;
+	}
+
+	idIndex.reserve(rows());
+	for (size_t r = 0; r < rows(); ++r) {
+		idIndex.emplace(getInt(r, 0), (int)r);		//First row wins on duplicated ids
+	}
+	return rows() > 0;
+}
+
+void CsvTable::clear()
+{
+	values.clear();
+	rowStart.assign(1, 0);
+	idIndex.clear();
+	invalidCells = 0;
+}
+
+size_t CsvTable::rows() const
+{
+	return rowStart.size() - 1;
+}
+
+size_t CsvTable::cells(size_t row) const
+{
+	if (row >= rows()) return 0;
+	return rowStart[row + 1] - rowStart[row];
+}
+
+double CsvTable::get(size_t row, size_t col) const
+{
+	if (col >= cells(row)) return 0;
+	return values[rowStart[row] + col];
+}
+
+int CsvTable::getInt(size_t row, size_t col) const
+{
+	double value = get(row, col);
+	return value == value ? (int)value : 0;		//null as it always read
+}
+
+const double *CsvTable::row(size_t row) const
+{
+	if (row >= rows()) return nullptr;
+	return &values[rowStart[row]];
+}
+
+int CsvTable::rowOf(int id) const
+{
+	unordered_map<int, int>::const_iterator it = idIndex.find(id);
+	return it == idIndex.end() ? -1 : it->second;
+}
+
+int CsvTable::badCells() const
+{
+	return invalidCells;
+}
+
+//Plain decimals ("-12.5e-3") with up to 19 digits are converted exactly with
+//one multiply/divide by an exact power of ten. Anything else goes through strtod.
+bool CsvTable::parseNumber(const char *begin, const char *end, double &value)
+{
+	while (begin < end && (*begin == ' ' || *begin == '"')) begin++;
+	while (end > begin && (end[-1] == ' ' || end[-1] == '"')) end--;
+	if (begin == end) return false;
+	if (end - begin == 4 && memcmp(begin, "null", 4) == 0) {
+		value = NAN;						//Feature not computed (or not finite), see formatCsvRow
+		return true;
+	}
+
+	const char *p = begin;
+	bool negative = false;
+	if (*p == '-' || *p == '+') {
+		negative = *p == '-';
+		p++;
+	}
+
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool anyDigit = false;
+	while (p < end && *p >= '0' && *p <= '9') {
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (*p - '0');
+			if (mantissa != 0) digits++;
+		}
+		else {
+			exponent++;
+		}
+		anyDigit = true;
+		p++;
+	}
+	if (p < end && *p == '.') {
+		p++;
+		while (p < end && *p >= '0' && *p <= '9') {
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa != 0) digits++;
+				exponent--;
+			}
+			anyDigit = true;
+			p++;
+		}
+	}
+	if (anyDigit && p < end && (*p == 'e' || *p == 'E')) {
+		p++;
+		bool negativeExp = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negativeExp = *p == '-';
+			p++;
+		}
+		int e = 0;
+		bool expDigit = false;
+		while (p < end && *p >= '0' && *p <= '9') {
+			if (e < 10000) e = e * 10 + (*p - '0');
+			expDigit = true;
+			p++;
+		}
+		if (!expDigit) anyDigit = false;
+		exponent += negativeExp ? -e : e;
+	}
+
+	if (anyDigit && p == end && digits < 19 && mantissa < ((uint64_t)1 << 53) && exponent >= -22 && exponent <= 22) {
+		double v = (double)mantissa;
+		v = exponent < 0 ? v / exactPowers[-exponent] : v * exactPowers[exponent];
+		value = negative ? -v : v;
+		return true;
+	}
+
+	//Long mantissas, huge exponents, inf/nan: let the C library decide
+	char buffer[64];
+	size_t length = end - begin;
+	if (length >= sizeof(buffer)) return false;
+	memcpy(buffer, begin, length);
+	buffer[length] = '\0';
+	char *parsed = nullptr;
+	value = strtod(buffer, &parsed);
+	return parsed == buffer + length;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+//Numeric CSV file parsed straight into doubles. Rows may have different
+//lengths (semantic_data.csv), cells past the end of a row read as 0.
+class CsvTable
+{
+public:
+	CsvTable();
+
+	bool load(const std::string &path, ThreadPool *pool = nullptr);	//Map and parse, lines split across pool
+	bool parse(const char *text, size_t length, ThreadPool *pool = nullptr);
+	void clear();
+
+	size_t rows() const;
+	size_t cells(size_t row) const;					//Number of cells in row
+	double get(size_t row, size_t col) const;
+	int getInt(size_t row, size_t col) const;
+	const double *row(size_t row) const;
+
+	int rowOf(int id) const;						//Row whose first cell is id, -1 if missing
+	int badCells() const;							//Cells that were not numbers, read as 0
+
+	static bool parseNumber(const char *begin, const char *end, double &value);	//Whole token must be a number, null is NaN
+
+private:
+	std::vector<double> values;						//All cells, row after row
+	std::vector<uint32_t> rowStart;					//rows()+1 offsets into values
+	std::unordered_map<int, int> idIndex;			//First cell -> row
+	int invalidCells;
+};
@@ -0,0 +1,96 @@
+#include "ExtractionQueue.h"
+
+ExtractionQueue::ExtractionQueue()
+	: clipsTotal(0), clipsProcessed(0), running(false), cancelled(false), result(false)
+{
+}
+
+ExtractionQueue::~ExtractionQueue()
+{
+	cancel();
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+void ExtractionQueue::start(std::function<bool()> extraction)
+{
+	if (thread.joinable()) {
+		cout << "[error: ExtractionQueue.cpp] extraction already started" << endl;
+		return;
+	}
+	running = true;
+	thread = std::thread(&ExtractionQueue::run, this, extraction);
+}
+
+void ExtractionQueue::run(std::function<bool()> extraction)
+{
+	bool extracted = extraction();
+	lock_guard<mutex> lock(queueMutex);
+	result = extracted;
+	running = false;
+}
+
+void ExtractionQueue::cancel()
+{
+	lock_guard<mutex> lock(queueMutex);
+	cancelled = true;
+}
+
+bool ExtractionQueue::isCancelled()
+{
+	lock_guard<mutex> lock(queueMutex);
+	return cancelled;
+}
+
+bool ExtractionQueue::isRunning()
+{
+	lock_guard<mutex> lock(queueMutex);
+	return running;
+}
+
+bool ExtractionQueue::succeeded()
+{
+	lock_guard<mutex> lock(queueMutex);
+	return !running && result;
+}
+
+void ExtractionQueue::setTotal(size_t clips)
+{
+	lock_guard<mutex> lock(queueMutex);
+	clipsTotal = clips;
+}
+
+void ExtractionQueue::push(const VideoFile &clip)
+{
+	lock_guard<mutex> lock(queueMutex);
+	clips.push_back(clip);
+	clipsProcessed++;
+}
+
+void ExtractionQueue::skip()
+{
+	lock_guard<mutex> lock(queueMutex);
+	clipsProcessed++;
+}
+
+size_t ExtractionQueue::take(vector<VideoFile> &taken)
+{
+	lock_guard<mutex> lock(queueMutex);
+	size_t count = clips.size();
+	taken.insert(taken.end(), clips.begin(), clips.end());
+	clips.clear();
+	return count;
+}
+
+size_t ExtractionQueue::total()
+{
+	lock_guard<mutex> lock(queueMutex);
+	return clipsTotal;
+}
+
+size_t ExtractionQueue::processed()
+{
+	lock_guard<mutex> lock(queueMutex);
+	return clipsProcessed;
+}
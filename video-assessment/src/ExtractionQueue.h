@@ -0,0 +1,48 @@
+#pragma once
+
+#include "VideoFile.h"
+
+#include <functional>
+#include <mutex>
+#include <thread>
+
+//Extraction on its own thread, clips handed to the gallery as they are done.
+//The extraction pushes every finished clip (or skips it) and checks for a
+//cancel between clips; the GL thread takes the clips pushed since its last
+//take once per frame, so the gallery grows while the rest is extracted.
+class ExtractionQueue
+{
+public:
+	ExtractionQueue();
+	~ExtractionQueue();							//Cancels, waits for the clip being extracted
+
+	void start(std::function<bool()> extraction);	//Runs on the queue thread, once
+	void cancel();								//Extraction stops at the next clip
+	bool isCancelled();
+	bool isRunning();							//False once the extraction returned
+	bool succeeded();							//Extraction returned true
+
+	//Extraction thread
+	void setTotal(size_t clips);
+	void push(const VideoFile &clip);			//Clip done, shown in the gallery
+	void skip();								//Clip done, not shown
+
+	size_t take(vector<VideoFile> &clips);		//Appends the clips pushed since the last take
+	size_t total();
+	size_t processed();							//Pushed and skipped
+
+private:
+	ExtractionQueue(const ExtractionQueue &);
+	ExtractionQueue &operator=(const ExtractionQueue &);
+
+	void run(std::function<bool()> extraction);
+
+	std::thread thread;
+	std::mutex queueMutex;
+	vector<VideoFile> clips;					//Pushed, not taken yet
+	size_t clipsTotal;
+	size_t clipsProcessed;
+	bool running;
+	bool cancelled;
+	bool result;
+};
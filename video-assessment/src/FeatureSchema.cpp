@@ -0,0 +1,123 @@
+#include "FeatureSchema.h"
+#include "CsvTable.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+	//Same text nlohmann::json produced: %.15g, ".0" on integral reals, null if not finite
+	void appendNumber(string &out, double value, FeatureKind kind)
+	{
+		char buffer[64];
+		if (!std::isfinite(value)) {
+			out += "null";
+			return;
+		}
+		if (kind == SCHEMA_INT) {
+			snprintf(buffer, sizeof(buffer), "%lld", (long long)value);
+			out += buffer;
+			return;
+		}
+		if (value == 0) {
+			out += std::signbit(value) ? "-0.0" : "0.0";
+			return;
+		}
+		int length = snprintf(buffer, sizeof(buffer), "%.15g", value);
+		for (int i = 0; i < length; ++i) {
+			if (buffer[i] == ',') buffer[i] = '.';		//Decimal comma locales
+		}
+		out.append(buffer, length);
+		if (strpbrk(buffer, ".eE") == nullptr) {
+			out += ".0";
+		}
+	}
+}
+
+void FeatureRecord::clear()
+{
+	for (int i = 0; i < FEATURE_COUNT; ++i) {
+		values[i] = 0;
+	}
+	stages = STAGE_ALL;
+}
+
+void FeatureRecord::setStages(unsigned computed)
+{
+	stages = computed;
+	for (int i = 0; i < FEATURE_COUNT; ++i) {
+		if ((featureSchema[i].stage & computed) == 0) values[i] = NAN;
+	}
+}
+
+bool FeatureRecord::isFinite() const
+{
+	for (int i = 0; i < FEATURE_COUNT; ++i) {
+		if ((featureSchema[i].stage & stages) != 0 && !std::isfinite(values[i])) return false;
+	}
+	return true;
+}
+
+unsigned featureStages(const VideoFeature *features, size_t count)
+{
+	unsigned stages = 0;
+	for (size_t i = 0; i < count; ++i) {
+		stages |= featureSchema[features[i]].stage;
+	}
+	return stages;
+}
+
+void projectFeatures(const FeatureRecord &record, const VideoFeature *inputs, size_t count, float *out)
+{
+	for (size_t i = 0; i < count; ++i) {
+		bool computed = (featureSchema[inputs[i]].stage & record.stages) != 0;
+		out[i] = computed ? (float)record[inputs[i]] : 0.0f;
+	}
+}
+
+string formatCsvRow(int id, const FeatureRecord &record)
+{
+	string row;
+	row.reserve(FEATURE_COUNT * 20);
+	appendNumber(row, id, SCHEMA_INT);
+	for (int i = 0; i < FEATURE_COUNT; ++i) {
+		row += ',';
+		appendNumber(row, record.values[i], featureSchema[i].kind);
+	}
+	return row;
+}
+
+//Stream formatting, as these files were always written
+string formatSemanticRow(const vector<pair<double, int> > &concepts)
+{
+	ostringstream row;
+	for (size_t i = 0; i < concepts.size(); ++i) {
+		row << (i > 0 ? "," : "") << concepts[i].second << "," << concepts[i].first;
+	}
+	return row.str();
+}
+
+string formatAudioRow(const vector<double> &audio)
+{
+	ostringstream row;
+	for (size_t i = 0; i < audio.size(); ++i) {
+		row << (i > 0 ? "," : "") << audio[i];
+	}
+	return row.str();
+}
+
+bool readCsvRow(const CsvTable &csv, int row, FeatureRecord &record)
+{
+	if (row < 0 || row >= (int)csv.rows()) {
+		return false;
+	}
+	for (int i = 0; i < FEATURE_COUNT; ++i) {
+		record.values[i] = csv.get(row, i + 1);		//Cells past a short row read as 0
+	}
+	record.stages = STAGE_ALL;						//Not computed ones read back as NaN
+	return true;
+}
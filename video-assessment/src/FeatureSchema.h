@@ -0,0 +1,228 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+class CsvTable;
+
+//Features computed per video by the extractor, in output.csv order (after ID).
+//Everything below is generated from this one list: the record the extractor
+//fills, the csv columns, the csv writer/reader and the SVM input projections.
+//Features kept per file in the gallery name their store column in FILE_COLUMNS
+//or VIDEO_COLUMNS (FeatureStore.h), which generate the rest.
+//
+//F(ID, name, kind, stage): name is the csv/legacy json key, kind SCHEMA_INT or
+//SCHEMA_REAL, stage the extractor step that computes it
+#define VIDEO_FEATURES(F) \
+	F(WIDTH,                 "width",                 SCHEMA_REAL, STAGE_VIDEO)         \
+	F(HEIGHT,                "height",                SCHEMA_REAL, STAGE_VIDEO)         \
+	F(RED_RATIO,             "red_ratio",             SCHEMA_REAL, STAGE_COLORS)        \
+	F(RED_MOMENTS1,          "red_moments1",          SCHEMA_REAL, STAGE_COLORS)        \
+	F(RED_MOMENTS2,          "red_moments2",          SCHEMA_REAL, STAGE_COLORS)        \
+	F(GREEN_RATIO,           "green_ratio",           SCHEMA_REAL, STAGE_COLORS)        \
+	F(GREEN_MOMENTS1,        "green_moments1",        SCHEMA_REAL, STAGE_COLORS)        \
+	F(GREEN_MOMENTS2,        "green_moments2",        SCHEMA_REAL, STAGE_COLORS)        \
+	F(BLUE_RATIO,            "blue_ratio",            SCHEMA_REAL, STAGE_COLORS)        \
+	F(BLUE_MOMENTS1,         "blue_moments1",         SCHEMA_REAL, STAGE_COLORS)        \
+	F(BLUE_MOMENTS2,         "blue_moments2",         SCHEMA_REAL, STAGE_COLORS)        \
+	F(FOCUS,                 "focus",                 SCHEMA_REAL, STAGE_FOCUS)         \
+	F(LUMINANCE,             "luminance",             SCHEMA_REAL, STAGE_COLORS)        \
+	F(LUMINANCE_STD,         "luminance_std",         SCHEMA_REAL, STAGE_COLORS)        \
+	F(RED_MOMENTS3,          "red_moments3",          SCHEMA_REAL, STAGE_COLORS)        \
+	F(RED_MOMENTS4,          "red_moments4",          SCHEMA_REAL, STAGE_COLORS)        \
+	F(GREEN_MOMENTS3,        "green_moments3",        SCHEMA_REAL, STAGE_COLORS)        \
+	F(GREEN_MOMENTS4,        "green_moments4",        SCHEMA_REAL, STAGE_COLORS)        \
+	F(BLUE_MOMENTS3,         "blue_moments3",         SCHEMA_REAL, STAGE_COLORS)        \
+	F(BLUE_MOMENTS4,         "blue_moments4",         SCHEMA_REAL, STAGE_COLORS)        \
+	F(DIF_HUES,              "dif_hues",              SCHEMA_REAL, STAGE_HSV)           \
+	F(FACES,                 "faces",                 SCHEMA_REAL, STAGE_HAAR)          \
+	F(FACES_AREA,            "faces_area",            SCHEMA_REAL, STAGE_HAAR)          \
+	F(SMILES,                "smiles",                SCHEMA_REAL, STAGE_HAAR)          \
+	F(RULE_OF_THIRDS,        "rule_of_thirds",        SCHEMA_REAL, STAGE_HAAR)          \
+	F(STATIC_SALIENCY,       "static_saliency",       SCHEMA_REAL, STAGE_SALIENCY)      \
+	F(RANK_SUM,              "rank_sum",              SCHEMA_REAL, STAGE_VIDEO)         \
+	F(FPS,                   "fps",                   SCHEMA_REAL, STAGE_VIDEO)         \
+	F(HUES_STD,              "hues_std",              SCHEMA_REAL, STAGE_HSV)           \
+	F(SHACKINESS,            "shackiness",            SCHEMA_REAL, STAGE_FLOW)          \
+	F(MOTION_MAG,            "motion_mag",            SCHEMA_REAL, STAGE_FLOW)          \
+	F(FG_AREA,               "fg_area",               SCHEMA_REAL, STAGE_BGSUB)         \
+	F(SHADOW_AREA,           "shadow_area",           SCHEMA_REAL, STAGE_BGSUB)         \
+	F(BG_AREA,               "bg_area",               SCHEMA_REAL, STAGE_BGSUB)         \
+	F(CAMERA_MOVE,           "camera_move",           SCHEMA_REAL, STAGE_BGSUB)         \
+	F(FOCUS_DIFF,            "focus_diff",            SCHEMA_REAL, STAGE_BGSUB)         \
+	F(AESTHETIC,             "aesthetic",             SCHEMA_INT,  STAGE_MODEL)         \
+	F(INTEREST,              "interest",              SCHEMA_INT,  STAGE_MODEL)         \
+	F(HUES_SKEWNESS,         "hues_skewness",         SCHEMA_REAL, STAGE_HSV)           \
+	F(HUES_KURTOSIS,         "hues_kurtosis",         SCHEMA_REAL, STAGE_HSV)           \
+	F(EH_0,                  "eh_0",                  SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_1,                  "eh_1",                  SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_2,                  "eh_2",                  SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_3,                  "eh_3",                  SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_4,                  "eh_4",                  SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_5,                  "eh_5",                  SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_6,                  "eh_6",                  SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_7,                  "eh_7",                  SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_8,                  "eh_8",                  SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_9,                  "eh_9",                  SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_10,                 "eh_10",                 SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_11,                 "eh_11",                 SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_12,                 "eh_12",                 SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_13,                 "eh_13",                 SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_14,                 "eh_14",                 SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_15,                 "eh_15",                 SCHEMA_REAL, STAGE_EDGES)         \
+	F(EH_16,                 "eh_16",                 SCHEMA_REAL, STAGE_EDGES)         \
+	F(ENTROPY,               "entropy",               SCHEMA_REAL, STAGE_ENTROPY)       \
+	F(EDGE_STRENGHT,         "edge_strenght",         SCHEMA_REAL, STAGE_EDGES)         \
+	F(LUMINANCE_SKEWNESS,    "luminance_skewness",    SCHEMA_REAL, STAGE_COLORS)        \
+	F(LUMINANCE_KURTOSIS,    "luminance_kurtosis",    SCHEMA_REAL, STAGE_COLORS)        \
+	F(ENTROPY_STD,           "entropy_std",           SCHEMA_REAL, STAGE_ENTROPY)       \
+	F(ENTROPY_SKEWNESS,      "entropy_skewness",      SCHEMA_REAL, STAGE_ENTROPY)       \
+	F(ENTROPY_KURTOSIS,      "entropy_kurtosis",      SCHEMA_REAL, STAGE_ENTROPY)       \
+	F(FOCUS_STD,             "focus_std",             SCHEMA_REAL, STAGE_FOCUS)         \
+	F(FOCUS_SKEWNESS,        "focus_skewness",        SCHEMA_REAL, STAGE_FOCUS)         \
+	F(FOCUS_KURTOSIS,        "focus_kurtosis",        SCHEMA_REAL, STAGE_FOCUS)         \
+	F(MAG_STD,               "mag_std",               SCHEMA_REAL, STAGE_FLOW)          \
+	F(MAG_SKEWNESS,          "mag_skewness",          SCHEMA_REAL, STAGE_FLOW)          \
+	F(MAG_KURTOSIS,          "mag_kurtosis",          SCHEMA_REAL, STAGE_FLOW)          \
+	F(UFLOWX_MEAN,           "uflowx_mean",           SCHEMA_REAL, STAGE_FLOW)          \
+	F(UFLOWX_STD,            "uflowx_std",            SCHEMA_REAL, STAGE_FLOW)          \
+	F(UFLOWX_SKEWNESS,       "uflowx_skewness",       SCHEMA_REAL, STAGE_FLOW)          \
+	F(UFLOWX_KURTOSIS,       "uflowx_kurtosis",       SCHEMA_REAL, STAGE_FLOW)          \
+	F(UFLOWY_MEAN,           "uflowy_mean",           SCHEMA_REAL, STAGE_FLOW)          \
+	F(UFLOWY_STD,            "uflowy_std",            SCHEMA_REAL, STAGE_FLOW)          \
+	F(UFLOWY_SKEWNESS,       "uflowy_skewness",       SCHEMA_REAL, STAGE_FLOW)          \
+	F(UFLOWY_KURTOSIS,       "uflowy_kurtosis",       SCHEMA_REAL, STAGE_FLOW)          \
+	F(SFLOWX_MEAN,           "sflowx_mean",           SCHEMA_REAL, STAGE_FLOW)          \
+	F(SFLOWX_STD,            "sflowx_std",            SCHEMA_REAL, STAGE_FLOW)          \
+	F(SFLOWX_SKEWNESS,       "sflowx_skewness",       SCHEMA_REAL, STAGE_FLOW)          \
+	F(SFLOWX_KURTOSIS,       "sflowx_kurtosis",       SCHEMA_REAL, STAGE_FLOW)          \
+	F(SFLOWY_MEAN,           "sflowy_mean",           SCHEMA_REAL, STAGE_FLOW)          \
+	F(SFLOWY_STD,            "sflowy_std",            SCHEMA_REAL, STAGE_FLOW)          \
+	F(SFLOWY_SKEWNESS,       "sflowy_skewness",       SCHEMA_REAL, STAGE_FLOW)          \
+	F(SFLOWY_KURTOSIS,       "sflowy_kurtosis",       SCHEMA_REAL, STAGE_FLOW)          \
+	F(COLORFULLNESS_RG1,     "colorfullness_rg1",     SCHEMA_REAL, STAGE_COLORFULLNESS) \
+	F(COLORFULLNESS_RG2,     "colorfullness_rg2",     SCHEMA_REAL, STAGE_COLORFULLNESS) \
+	F(COLORFULLNESS_YB1,     "colorfullness_yb1",     SCHEMA_REAL, STAGE_COLORFULLNESS) \
+	F(COLORFULLNESS_YB2,     "colorfullness_yb2",     SCHEMA_REAL, STAGE_COLORFULLNESS) \
+	F(DURATION,              "duration",              SCHEMA_REAL, STAGE_VIDEO)         \
+	F(SATURATION_1,          "saturation_1",          SCHEMA_REAL, STAGE_HSV)           \
+	F(SATURATION_2,          "saturation_2",          SCHEMA_REAL, STAGE_HSV)           \
+	F(BRIGHTNESS_1,          "brightness_1",          SCHEMA_REAL, STAGE_HSV)           \
+	F(BRIGHTNESS_2,          "brightness_2",          SCHEMA_REAL, STAGE_HSV)           \
+	F(COLORFULL_1,           "colorfull_1",           SCHEMA_REAL, STAGE_COLORFULLNESS) \
+	F(COLORFULL_2,           "colorfull_2",           SCHEMA_REAL, STAGE_COLORFULLNESS)
+
+enum FeatureKind
+{
+	SCHEMA_INT,				//Written without decimals, as the int predictions always were
+	SCHEMA_REAL
+};
+
+//Extractor steps, as bits. Semantic, audio and dominant colors have their own
+//outputs and are not part of the record.
+enum ExtractorStage
+{
+	STAGE_VIDEO = 1 << 0,			//Container properties, always read
+	STAGE_COLORS = 1 << 1,			//processColors, always run
+	STAGE_COLORFULLNESS = 1 << 2,
+	STAGE_FOCUS = 1 << 3,
+	STAGE_HSV = 1 << 4,
+	STAGE_HAAR = 1 << 5,
+	STAGE_SALIENCY = 1 << 6,
+	STAGE_FLOW = 1 << 7,
+	STAGE_BGSUB = 1 << 8,
+	STAGE_EDGES = 1 << 9,
+	STAGE_ENTROPY = 1 << 10,
+	STAGE_MODEL = 1 << 11,			//SVM predictions, set by the gallery
+	STAGE_ALL = (STAGE_MODEL << 1) - 1
+};
+
+enum VideoFeature
+{
+#define SCHEMA_FEATURE_ENUM(id, name, kind, stage) FEAT_##id,
+	VIDEO_FEATURES(SCHEMA_FEATURE_ENUM)
+#undef SCHEMA_FEATURE_ENUM
+	FEATURE_COUNT,
+	NO_FEATURE = FEATURE_COUNT		//Store column not copied from a feature, see FILE_COLUMNS
+};
+
+//Columns of output.csv: file ID, then the features
+enum OutputCsvColumn
+{
+	CSV_ID,
+#define SCHEMA_CSV_ENUM(id, name, kind, stage) CSV_##id,
+	VIDEO_FEATURES(SCHEMA_CSV_ENUM)
+#undef SCHEMA_CSV_ENUM
+	CSV_COLUMNS
+};
+
+static_assert(CSV_COLUMNS == FEATURE_COUNT + 1, "csv columns out of sync with features");
+static_assert(CSV_ENTROPY == 58 && CSV_COLORFULL_2 == 97, "output.csv layout changed, old files won't load");
+
+struct FeatureInfo
+{
+	const char *name;
+	FeatureKind kind;
+	ExtractorStage stage;
+};
+
+constexpr FeatureInfo featureSchema[FEATURE_COUNT] = {
+#define SCHEMA_FEATURE_INFO(id, name, kind, stage) { name, kind, stage },
+	VIDEO_FEATURES(SCHEMA_FEATURE_INFO)
+#undef SCHEMA_FEATURE_INFO
+};
+
+//Inputs of the aesthetic SVM, in training csv order (A2018C_40_reorg)
+constexpr VideoFeature aestheticInputs[] = {
+	FEAT_SFLOWX_STD, FEAT_WIDTH, FEAT_ENTROPY_STD, FEAT_FOCUS, FEAT_RULE_OF_THIRDS,
+	FEAT_MAG_KURTOSIS, FEAT_FPS, FEAT_SFLOWY_STD, FEAT_ENTROPY_SKEWNESS, FEAT_SFLOWX_SKEWNESS,
+	FEAT_SMILES, FEAT_SFLOWY_MEAN, FEAT_HEIGHT, FEAT_DIF_HUES, FEAT_SFLOWX_MEAN,
+	FEAT_GREEN_MOMENTS2, FEAT_BLUE_MOMENTS4, FEAT_RED_MOMENTS1, FEAT_SHACKINESS, FEAT_MOTION_MAG,
+	FEAT_SFLOWY_KURTOSIS, FEAT_FOCUS_DIFF
+};
+
+//Inputs of the interestingness SVM, in training csv order (i_beach_train_gui)
+constexpr VideoFeature interestInputs[] = {
+	FEAT_RED_RATIO, FEAT_SFLOWX_STD, FEAT_DIF_HUES, FEAT_DURATION, FEAT_HUES_KURTOSIS,
+	FEAT_WIDTH, FEAT_UFLOWY_STD, FEAT_UFLOWY_KURTOSIS, FEAT_COLORFULLNESS_RG1, FEAT_RED_MOMENTS3,
+	FEAT_FOCUS, FEAT_GREEN_RATIO, FEAT_COLORFULLNESS_YB1, FEAT_FOCUS_KURTOSIS, FEAT_UFLOWX_MEAN,
+	FEAT_MAG_KURTOSIS, FEAT_UFLOWX_KURTOSIS, FEAT_BLUE_RATIO, FEAT_FACES, FEAT_ENTROPY_SKEWNESS,
+	FEAT_HUES_STD, FEAT_ENTROPY, FEAT_HEIGHT, FEAT_BLUE_MOMENTS3, FEAT_FPS,
+	FEAT_HUES_SKEWNESS, FEAT_UFLOWY_SKEWNESS, FEAT_BLUE_MOMENTS1, FEAT_FOCUS_SKEWNESS, FEAT_SMILES
+};
+
+constexpr size_t AESTHETIC_INPUTS = sizeof(aestheticInputs) / sizeof(aestheticInputs[0]);
+constexpr size_t INTEREST_INPUTS = sizeof(interestInputs) / sizeof(interestInputs[0]);
+static_assert(AESTHETIC_INPUTS == 22, "aesthetic model is trained on 22 features");
+static_assert(INTEREST_INPUTS == 30, "interestingness model is trained on 30 features");
+
+//Stages needed to compute the given features, OR of ExtractorStage bits
+unsigned featureStages(const VideoFeature *features, size_t count);
+
+//All features of one video, fixed layout. Features of the stages that didn't
+//run are NaN: null in output.csv and the store, left out of filters and sorts
+struct FeatureRecord
+{
+	double values[FEATURE_COUNT];
+	unsigned stages;				//ExtractorStage bits that computed the values
+
+	double &operator[](VideoFeature f) { return values[f]; }
+	double operator[](VideoFeature f) const { return values[f]; }
+	void clear();					//All 0, all stages
+	void setStages(unsigned computed);	//Features of the other stages become NaN
+	bool isFinite() const;			//False if a computed feature is nan/inf (written as null to csv)
+};
+
+//Copy the inputs of a model out of a record, as floats for cv::Mat. Features
+//not computed go in as 0, as the models always got them
+void projectFeatures(const FeatureRecord &record, const VideoFeature *inputs, size_t count, float *out);
+
+//One output.csv line without newline, numbers formatted like the old json writer
+std::string formatCsvRow(int id, const FeatureRecord &record);
+bool readCsvRow(const CsvTable &csv, int row, FeatureRecord &record);	//False if row is missing
+
+//semantic_data.csv (classId,probability per concept) and audio_result.csv lines, without newline
+std::string formatSemanticRow(const std::vector<std::pair<double, int> > &concepts);
+std::string formatAudioRow(const std::vector<double> &audio);
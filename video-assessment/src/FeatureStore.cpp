@@ -0,0 +1,576 @@
+#include "FeatureStore.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+const FeatureColumnInfo featureColumns[COL_COUNT] = {
+#define FEATURE_COLUMN_INFO(col, type, member, xml, feature, filter) { #col, type },
+	FILE_COLUMNS(FEATURE_COLUMN_INFO)
+	VIDEO_COLUMNS(FEATURE_COLUMN_INFO)
+#undef FEATURE_COLUMN_INFO
+};
+
+namespace {
+
+	const char storeMagic[4] = { 'V', 'Q', 'A', 'F' };
+
+	struct StoreHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t rowCount;
+		uint32_t columnCount;
+		uint64_t indexOffset;
+		uint64_t dictionaryOffset;
+		uint32_t stringCount;
+		uint32_t reserved0;
+		uint64_t stringDataOffset;			//Version 2, version 1 strings follow their offsets
+		uint32_t reserved[2];
+	};
+
+	struct StoreColumn
+	{
+		char name[24];
+		uint32_t type;
+		uint32_t reserved;
+		uint64_t offset;
+	};
+
+	uint64_t align8(uint64_t v)
+	{
+		return (v + 7) & ~(uint64_t)7;
+	}
+
+	bool seekTo(FILE *f, uint64_t offset)
+	{
+#ifdef _WIN32
+		return _fseeki64(f, (__int64)offset, SEEK_SET) == 0;
+#else
+		return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+	}
+
+	bool syncFile(FILE *f)
+	{
+		if (fflush(f) != 0) {
+			return false;
+		}
+#ifdef _WIN32
+		return _commit(_fileno(f)) == 0;
+#else
+		return fsync(fileno(f)) == 0;
+#endif
+	}
+
+	bool writeAt(FILE *f, uint64_t offset, const void *data, size_t bytes)
+	{
+		return bytes == 0 || (seekTo(f, offset) && fwrite(data, 1, bytes, f) == bytes);
+	}
+
+	bool replaceFile(const string &from, const string &to)
+	{
+#ifdef _WIN32
+		return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		return rename(from.c_str(), to.c_str()) == 0;
+#endif
+	}
+}
+
+////////////////////////////////FeatureStore////////////////////////////////
+
+FeatureStore::FeatureStore()
+{
+	patchFile = nullptr;
+	close();
+}
+
+FeatureStore::~FeatureStore()
+{
+	close();
+}
+
+bool FeatureStore::open(const string &path)
+{
+	close();
+	if (!file.open(path)) {
+		return false;
+	}
+
+	const char *base = file.data();
+	size_t length = file.size();
+	if (length < sizeof(StoreHeader)) {
+		cout << "[error: FeatureStore.cpp] " << path << " is too small" << endl;
+		close();
+		return false;
+	}
+
+	StoreHeader header;
+	memcpy(&header, base, sizeof(header));
+	if (memcmp(header.magic, storeMagic, 4) != 0 || (header.version != VERSION && header.version != 1)) {
+		cout << "[error: FeatureStore.cpp] " << path << " is not a version " << VERSION << " feature store" << endl;
+		close();
+		return false;
+	}
+
+	uint64_t columnTableEnd = sizeof(StoreHeader) + (uint64_t)header.columnCount * sizeof(StoreColumn);
+	uint64_t indexEnd = header.indexOffset + (uint64_t)header.rowCount * 2 * sizeof(int32_t);
+	uint64_t offsetsEnd = header.dictionaryOffset + ((uint64_t)header.stringCount + 1) * sizeof(uint32_t);
+	uint64_t dataOffset = header.version == 1 ? offsetsEnd : header.stringDataOffset;
+	if (columnTableEnd > length || indexEnd > length || offsetsEnd > length || dataOffset > length) {
+		cout << "[error: FeatureStore.cpp] " << path << " is truncated" << endl;
+		close();
+		return false;
+	}
+
+	rowCount = header.rowCount;
+	index = (const int32_t *)(base + header.indexOffset);
+	stringCount = header.stringCount;
+	stringOffsets = (const uint32_t *)(base + header.dictionaryOffset);
+	stringData = base + dataOffset;
+	if (dataOffset + stringOffsets[stringCount] > length) {
+		cout << "[error: FeatureStore.cpp] " << path << " dictionary is truncated" << endl;
+		close();
+		return false;
+	}
+
+	//Resolve columns by name so stores with a different column set still load
+	const StoreColumn *table = (const StoreColumn *)(base + sizeof(StoreHeader));
+	for (uint32_t t = 0; t < header.columnCount; ++t) {
+		StoreColumn col = table[t];
+		col.name[sizeof(col.name) - 1] = '\0';
+		if (col.offset + (uint64_t)rowCount * 4 > length) {
+			continue;
+		}
+		for (int c = 0; c < COL_COUNT; ++c) {
+			if (featureColumns[c].type == (FeatureColumnType)col.type && strcmp(featureColumns[c].name, col.name) == 0) {
+				columns[c] = base + col.offset;
+				columnOffsets[c] = col.offset;
+				break;
+			}
+		}
+	}
+
+	storePath = path;
+	return true;
+}
+
+void FeatureStore::close()
+{
+	if (patchFile != nullptr) {
+		fclose(patchFile);
+		patchFile = nullptr;
+	}
+	file.close();
+	storePath.clear();
+	rowCount = 0;
+	for (int c = 0; c < COL_COUNT; ++c) {
+		columns[c] = nullptr;
+		columnOffsets[c] = 0;
+	}
+	index = nullptr;
+	stringCount = 0;
+	stringOffsets = nullptr;
+	stringData = nullptr;
+	stringIds.clear();
+}
+
+bool FeatureStore::isOpen() const
+{
+	return file.isOpen();
+}
+
+uint32_t FeatureStore::size() const
+{
+	return rowCount;
+}
+
+int FeatureStore::rowOf(int fileID) const
+{
+	int lo = 0;
+	int hi = (int)rowCount - 1;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		int id = index[mid * 2];
+		if (id == fileID) return index[mid * 2 + 1];
+		if (id < fileID) lo = mid + 1;
+		else hi = mid - 1;
+	}
+	return -1;
+}
+
+bool FeatureStore::hasColumn(FeatureColumn c) const
+{
+	return columns[c] != nullptr;
+}
+
+int FeatureStore::getInt(uint32_t row, FeatureColumn c) const
+{
+	if (columns[c] == nullptr || row >= rowCount) return 0;
+	int32_t v;
+	memcpy(&v, columns[c] + row * 4, 4);
+	return v;
+}
+
+float FeatureStore::getFloat(uint32_t row, FeatureColumn c) const
+{
+	if (columns[c] == nullptr || row >= rowCount) return 0;
+	float v;
+	memcpy(&v, columns[c] + row * 4, 4);
+	return v;
+}
+
+string FeatureStore::getString(uint32_t row, FeatureColumn c) const
+{
+	int id = getInt(row, c);
+	if (columns[c] == nullptr || id < 0 || (uint32_t)id >= stringCount) return "";
+	return string(stringData + stringOffsets[id], stringOffsets[id + 1] - stringOffsets[id] - 1);
+}
+
+const float *FeatureStore::floatColumn(FeatureColumn c) const
+{
+	if (featureColumns[c].type != FEATURE_FLOAT) return nullptr;
+	return (const float *)columns[c];
+}
+
+bool FeatureStore::patchInt(uint32_t row, FeatureColumn c, int value)
+{
+	int32_t v = value;
+	return patchCell(row, c, &v);
+}
+
+bool FeatureStore::patchFloat(uint32_t row, FeatureColumn c, float value)
+{
+	return patchCell(row, c, &value);
+}
+
+bool FeatureStore::patchString(uint32_t row, FeatureColumn c, const string &value)
+{
+	int32_t id = findString(value);
+	if (id < 0) {
+		return false;
+	}
+	return patchCell(row, c, &id);
+}
+
+bool FeatureStore::patchCell(uint32_t row, FeatureColumn c, const void *value)
+{
+	if (columns[c] == nullptr || row >= rowCount) {
+		return false;
+	}
+	if (patchFile == nullptr) {
+		patchFile = fopen(storePath.c_str(), "r+b");
+		if (patchFile == nullptr) {
+			return false;
+		}
+	}
+	return seekTo(patchFile, columnOffsets[c] + (uint64_t)row * 4) && fwrite(value, 1, 4, patchFile) == 4;
+}
+
+bool FeatureStore::sync()
+{
+	return patchFile == nullptr || syncFile(patchFile);
+}
+
+int FeatureStore::findString(const string &value)
+{
+	if (stringIds.empty()) {
+		for (uint32_t s = 0; s < stringCount; ++s) {
+			stringIds[string(stringData + stringOffsets[s], stringOffsets[s + 1] - stringOffsets[s] - 1)] = s;
+		}
+	}
+	unordered_map<string, int>::const_iterator it = stringIds.find(value);
+	return it == stringIds.end() ? -1 : it->second;
+}
+
+//////////////////////////////FeatureStoreWriter//////////////////////////////
+
+FeatureStoreWriter::FeatureStoreWriter()
+{
+	clear();
+}
+
+void FeatureStoreWriter::clear()
+{
+	for (int c = 0; c < COL_COUNT; ++c) {
+		cells[c].clear();
+	}
+	strings.clear();
+	stringIds.clear();
+	internString("");		//id 0 is the empty string, so a zero cell reads as ""
+	committedPath.clear();
+	committedRows = committedStrings = 0;
+	committedBytes = 0;
+	maxCommittedID = INT32_MIN;
+	layout(0, 0, 0);
+}
+
+uint32_t FeatureStoreWriter::addRow()
+{
+	for (int c = 0; c < COL_COUNT; ++c) {
+		cells[c].push_back(0);
+	}
+	return (uint32_t)cells[0].size() - 1;
+}
+
+uint32_t FeatureStoreWriter::size() const
+{
+	return (uint32_t)cells[0].size();
+}
+
+void FeatureStoreWriter::setInt(uint32_t row, FeatureColumn c, int value)
+{
+	int32_t v = value;
+	memcpy(&cells[c][row], &v, 4);
+}
+
+void FeatureStoreWriter::setFloat(uint32_t row, FeatureColumn c, double value)
+{
+	float v = (float)value;
+	memcpy(&cells[c][row], &v, 4);
+}
+
+void FeatureStoreWriter::setString(uint32_t row, FeatureColumn c, const string &value)
+{
+	cells[c][row] = internString(value);
+}
+
+uint32_t FeatureStoreWriter::internString(const string &value)
+{
+	unordered_map<string, uint32_t>::const_iterator it = stringIds.find(value);
+	if (it != stringIds.end()) {
+		return it->second;
+	}
+	uint32_t id = (uint32_t)strings.size();
+	strings.push_back(value);
+	stringIds[value] = id;
+	return id;
+}
+
+//Where every section goes for the given room, rows and strings past the
+//committed ones are written into it by an append
+void FeatureStoreWriter::layout(uint32_t rows, uint32_t stringSlots, uint64_t stringBytes)
+{
+	rowCapacity = rows;
+	stringCapacity = stringSlots;
+	stringByteCapacity = stringBytes;
+	uint64_t offset = align8(sizeof(StoreHeader) + COL_COUNT * sizeof(StoreColumn));
+	for (int c = 0; c < COL_COUNT; ++c) {
+		columnOffsets[c] = offset;
+		offset = align8(offset + (uint64_t)rows * 4);
+	}
+	indexOffset = offset;
+	dictionaryOffset = align8(indexOffset + (uint64_t)rows * 2 * sizeof(int32_t));
+	stringDataOffset = align8(dictionaryOffset + ((uint64_t)stringSlots + 1) * sizeof(uint32_t));
+}
+
+bool FeatureStoreWriter::commit(const string &path)
+{
+	uint32_t rows = size();
+	uint64_t bytes = 0;
+	for (size_t s = 0; s < strings.size(); ++s) {
+		bytes += strings[s].size() + 1;
+	}
+
+	//Appended when the new rows fit and sort after the committed ones in the index
+	bool appendable = path == committedPath && rows <= rowCapacity && strings.size() <= stringCapacity &&
+		bytes <= stringByteCapacity && rows >= committedRows;
+	int32_t lastID = maxCommittedID;
+	for (uint32_t r = committedRows; appendable && r < rows; ++r) {
+		int32_t id;
+		memcpy(&id, &cells[COL_ID][r], 4);
+		appendable = id > lastID;
+		lastID = id;
+	}
+	if (appendable) {
+		return append(bytes);
+	}
+
+	//Committed again, room for as many again so the next commits append
+	bool again = path == committedPath;
+	layout(again ? rows * 2 : rows, again ? (uint32_t)strings.size() * 2 : (uint32_t)strings.size(), again ? bytes * 2 : bytes);
+	committedPath.clear();
+	if (!rewrite(path)) {
+		return false;
+	}
+	committedPath = path;
+	committedRows = rows;
+	committedStrings = (uint32_t)strings.size();
+	committedBytes = bytes;
+	maxCommittedID = lastCommittedID();
+	return true;
+}
+
+int32_t FeatureStoreWriter::lastCommittedID() const
+{
+	int32_t last = INT32_MIN;
+	for (uint32_t r = 0; r < size(); ++r) {
+		int32_t id;
+		memcpy(&id, &cells[COL_ID][r], 4);
+		last = max(last, id);
+	}
+	return last;
+}
+
+void FeatureStoreWriter::fillHeader(void *out) const
+{
+	StoreHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, storeMagic, 4);
+	header.version = FeatureStore::VERSION;
+	header.rowCount = size();
+	header.columnCount = COL_COUNT;
+	header.indexOffset = indexOffset;
+	header.dictionaryOffset = dictionaryOffset;
+	header.stringCount = (uint32_t)strings.size();
+	header.stringDataOffset = stringDataOffset;
+	memcpy(out, &header, sizeof(header));
+}
+
+bool FeatureStoreWriter::rewrite(const string &path) const
+{
+	uint32_t rows = size();
+	StoreHeader header;
+	fillHeader(&header);
+
+	vector<StoreColumn> table(COL_COUNT);
+	for (int c = 0; c < COL_COUNT; ++c) {
+		memset(&table[c], 0, sizeof(StoreColumn));
+		strncpy(table[c].name, featureColumns[c].name, sizeof(table[c].name) - 1);
+		table[c].type = featureColumns[c].type;
+		table[c].offset = columnOffsets[c];
+	}
+
+	//fileID index, sorted for binary search
+	vector<pair<int32_t, uint32_t> > index(rows);
+	for (uint32_t r = 0; r < rows; ++r) {
+		int32_t id;
+		memcpy(&id, &cells[COL_ID][r], 4);
+		index[r] = make_pair(id, r);
+	}
+	sort(index.begin(), index.end());
+
+	//Dictionary, offsets then nul terminated strings
+	vector<uint32_t> stringOffsets(strings.size() + 1, 0);
+	for (size_t s = 0; s < strings.size(); ++s) {
+		stringOffsets[s + 1] = stringOffsets[s] + (uint32_t)strings[s].size() + 1;
+	}
+
+	string tmpPath = path + ".tmp";
+	ofstream out(tmpPath.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!out.is_open()) {
+		cout << "[error: FeatureStore.cpp] cannot write " << tmpPath << endl;
+		return false;
+	}
+
+	//Room past the rows and strings is zeros, appends fill it
+	vector<char> zeros;
+	auto padTo = [&](uint64_t offset) {
+		uint64_t at = (uint64_t)out.tellp();
+		if (offset > at) {
+			zeros.assign((size_t)(offset - at), 0);
+			out.write(&zeros[0], zeros.size());
+		}
+	};
+	out.write((const char *)&header, sizeof(header));
+	out.write((const char *)&table[0], COL_COUNT * sizeof(StoreColumn));
+	for (int c = 0; c < COL_COUNT; ++c) {
+		padTo(table[c].offset);
+		if (rows > 0) out.write((const char *)&cells[c][0], (streamsize)rows * 4);
+	}
+	padTo(indexOffset);
+	for (uint32_t r = 0; r < rows; ++r) {
+		out.write((const char *)&index[r].first, 4);
+		out.write((const char *)&index[r].second, 4);
+	}
+	padTo(dictionaryOffset);
+	out.write((const char *)&stringOffsets[0], stringOffsets.size() * sizeof(uint32_t));
+	padTo(stringDataOffset);
+	for (size_t s = 0; s < strings.size(); ++s) {
+		out.write(strings[s].c_str(), strings[s].size() + 1);
+	}
+	padTo(stringDataOffset + stringByteCapacity);
+	out.close();
+
+	if (out.fail() || !replaceFile(tmpPath, path)) {
+		cout << "[error: FeatureStore.cpp] cannot commit " << path << endl;
+		remove(tmpPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+//New cells, index entries and strings go into the room after the committed
+//ones, which readers of the old header don't look at. Synced, then the header
+//is written, so a crash leaves the previous commit whole
+bool FeatureStoreWriter::append(uint64_t bytes)
+{
+	uint32_t rows = size();
+	if (rows == committedRows && strings.size() == committedStrings) {
+		return true;
+	}
+	FILE *f = fopen(committedPath.c_str(), "r+b");
+	if (f == nullptr) {
+		cout << "[error: FeatureStore.cpp] cannot write " << committedPath << endl;
+		return false;
+	}
+
+	bool ok = true;
+	uint32_t added = rows - committedRows;
+	for (int c = 0; ok && c < COL_COUNT && added > 0; ++c) {
+		ok = writeAt(f, columnOffsets[c] + (uint64_t)committedRows * 4, &cells[c][committedRows], (size_t)added * 4);
+	}
+	vector<int32_t> index;
+	for (uint32_t r = committedRows; r < rows; ++r) {
+		int32_t id;
+		memcpy(&id, &cells[COL_ID][r], 4);
+		index.push_back(id);
+		index.push_back((int32_t)r);
+	}
+	ok = ok && writeAt(f, indexOffset + (uint64_t)committedRows * 2 * sizeof(int32_t), index.data(), index.size() * sizeof(int32_t));
+
+	vector<uint32_t> offsets;
+	string data;
+	uint32_t end = (uint32_t)committedBytes;
+	for (size_t s = committedStrings; s < strings.size(); ++s) {
+		end += (uint32_t)strings[s].size() + 1;
+		offsets.push_back(end);
+		data.append(strings[s].c_str(), strings[s].size() + 1);
+	}
+	ok = ok && writeAt(f, dictionaryOffset + ((uint64_t)committedStrings + 1) * sizeof(uint32_t), offsets.data(), offsets.size() * sizeof(uint32_t));
+	ok = ok && writeAt(f, stringDataOffset + committedBytes, data.data(), data.size());
+
+	StoreHeader header;
+	fillHeader(&header);
+	ok = ok && syncFile(f) && writeAt(f, 0, &header, sizeof(header)) && syncFile(f);
+	fclose(f);
+	if (!ok) {
+		cout << "[error: FeatureStore.cpp] cannot append to " << committedPath << endl;
+		committedPath.clear();					//Written whole next time
+		return false;
+	}
+	int32_t id;
+	for (uint32_t r = committedRows; r < rows; ++r) {
+		memcpy(&id, &cells[COL_ID][r], 4);
+		maxCommittedID = max(maxCommittedID, id);
+	}
+	committedRows = rows;
+	committedStrings = (uint32_t)strings.size();
+	committedBytes = bytes;
+	return true;
+}
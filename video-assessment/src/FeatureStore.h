@@ -0,0 +1,259 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.h"
+
+//Binary columnar store with the metadata of every clip. Replaces output.csv,
+//semantic_data.csv, audio_result.csv and the per-file xml as load source.
+//
+//Layout (little endian):
+//  header | column table | column blocks (rowCount x 4 bytes each) | fileID index | string offsets | string data
+//Every section may have room past its used part, which a later commit appends into.
+//Columns are matched by name when opening, so a store written with an older
+//column set still opens (missing columns read as 0). Layout changes bump VERSION.
+
+enum FeatureColumnType
+{
+	FEATURE_INT,
+	FEATURE_FLOAT,
+	FEATURE_STRING			//int32 id into the string dictionary
+};
+
+//Metadata of every file, one entry per store column in store order (journal
+//records keep the column number, so entries are only ever added at the end).
+//The column enum and table, store and xml reading/writing, the copy from the
+//extracted features and the filter table row are all generated from these lists.
+//
+//F(COL, type, member, xml, feature, filter):
+//  COL      store column and xml tag
+//  member   File (FILE_COLUMNS) or VideoFile (VIDEO_COLUMNS) field
+//  xml      parent element in the metadata xml, FILE for top level. KEY fields
+//           identify the file (set from the folder listing), never read back
+//  feature  VideoFeature it is copied from after extraction, NO_FEATURE if set elsewhere
+//  filter   FilterTable column, NO_FILTER if not filterable
+#define FILE_COLUMNS(F) \
+	F(ID,              FEATURE_INT,    fileID,             FILE,       NO_FEATURE,                FILE_ID)         \
+	F(NAME,            FEATURE_STRING, name,               KEY,        NO_FEATURE,                NO_FILTER)       \
+	F(EXTENSION,       FEATURE_STRING, extension,          KEY,        NO_FEATURE,                NO_FILTER)       \
+	F(FILE_PATH,       FEATURE_STRING, path,               KEY,        NO_FEATURE,                NO_FILTER)       \
+	F(X,               FEATURE_INT,    resX,               RESOLUTION, FEAT_WIDTH,                NO_FILTER)       \
+	F(Y,               FEATURE_INT,    resY,               RESOLUTION, FEAT_HEIGHT,               NO_FILTER)       \
+	F(RATE,            FEATURE_INT,    rate,               FILE,       NO_FEATURE,                RATE)            \
+	F(LUMINANCE,       FEATURE_FLOAT,  luminance,          FILE,       FEAT_LUMINANCE,            LUMINANCE)       \
+	F(SHARPNESS,       FEATURE_FLOAT,  sharpness,          FILE,       FEAT_FOCUS,                SHARPNESS)       \
+	F(DIF_HUES,        FEATURE_FLOAT,  dif_hues,           FILE,       FEAT_DIF_HUES,             DIF_HUES)        \
+	F(SIMILARITY,      FEATURE_FLOAT,  similarityIndex,    FILE,       NO_FEATURE,                SIMILARITY)      \
+	F(REFERENCE,       FEATURE_STRING, referenceName,      FILE,       NO_FEATURE,                NO_FILTER)       \
+	F(HUMAN_FACE,      FEATURE_INT,    humanFace,          FILE,       NO_FEATURE,                HUMAN_FACE)      \
+	F(AVG_FACES,       FEATURE_FLOAT,  avgFaces,           FILE,       FEAT_FACES,                AVG_FACES)       \
+	F(FACE_AREA,       FEATURE_FLOAT,  faceArea,           FILE,       FEAT_FACES_AREA,           FACE_AREA)       \
+	F(AVG_HAAR,        FEATURE_FLOAT,  smiles,             FILE,       FEAT_SMILES,               SMILES)          \
+	F(RULE_OF_THIRDS,  FEATURE_FLOAT,  rule3,              FILE,       FEAT_RULE_OF_THIRDS,       RULE3)           \
+	F(STATIC_SALIENCY, FEATURE_FLOAT,  static_saliency,    FILE,       FEAT_STATIC_SALIENCY,      STATIC_SALIENCY) \
+	F(ENTROPY,         FEATURE_FLOAT,  entropy,            FILE,       FEAT_ENTROPY,              ENTROPY)         \
+	F(EHSTRENGHT,      FEATURE_FLOAT,  edgeStrenght,       FILE,       FEAT_EDGE_STRENGHT,        NO_FILTER)       \
+	F(RED1,            FEATURE_FLOAT,  redMoments.first,   COLOUR,     FEAT_RED_MOMENTS1,         NO_FILTER)       \
+	F(GREEN1,          FEATURE_FLOAT,  greenMoments.first, COLOUR,     FEAT_GREEN_MOMENTS1,       NO_FILTER)       \
+	F(BLUE1,           FEATURE_FLOAT,  blueMoments.first,  COLOUR,     FEAT_BLUE_MOMENTS1,        NO_FILTER)       \
+	F(RED2,            FEATURE_FLOAT,  redMoments.second,  COLOUR,     FEAT_RED_MOMENTS2,         NO_FILTER)       \
+	F(GREEN2,          FEATURE_FLOAT,  greenMoments.second, COLOUR,    FEAT_GREEN_MOMENTS2,       NO_FILTER)       \
+	F(BLUE2,           FEATURE_FLOAT,  blueMoments.second, COLOUR,     FEAT_BLUE_MOMENTS2,        NO_FILTER)       \
+	F(RED_RATIO,       FEATURE_FLOAT,  redRatio,           COLOUR,     FEAT_RED_RATIO,            RED_RATIO)       \
+	F(GREEN_RATIO,     FEATURE_FLOAT,  greenRatio,         COLOUR,     FEAT_GREEN_RATIO,          GREEN_RATIO)     \
+	F(BLUE_RATIO,      FEATURE_FLOAT,  blueRatio,          COLOUR,     FEAT_BLUE_RATIO,           BLUE_RATIO)      \
+	F(EH1,            FEATURE_INT,    eh1,               EH,         FEAT_EH_0,                 NO_FILTER)       \
+	F(EH2,            FEATURE_INT,    eh2,               EH,         FEAT_EH_1,                 NO_FILTER)       \
+	F(EH3,            FEATURE_INT,    eh3,               EH,         FEAT_EH_2,                 NO_FILTER)       \
+	F(EH4,            FEATURE_INT,    eh4,               EH,         FEAT_EH_3,                 NO_FILTER)       \
+	F(EH5,            FEATURE_INT,    eh5,               EH,         FEAT_EH_4,                 NO_FILTER)       \
+	F(EH6,            FEATURE_INT,    eh6,               EH,         FEAT_EH_5,                 NO_FILTER)       \
+	F(EH7,            FEATURE_INT,    eh7,               EH,         FEAT_EH_6,                 NO_FILTER)       \
+	F(EH8,            FEATURE_INT,    eh8,               EH,         FEAT_EH_7,                 NO_FILTER)       \
+	F(EH9,            FEATURE_INT,    eh9,               EH,         FEAT_EH_8,                 NO_FILTER)       \
+	F(EH10,           FEATURE_INT,    eh10,              EH,         FEAT_EH_9,                 NO_FILTER)       \
+	F(EH11,           FEATURE_INT,    eh11,              EH,         FEAT_EH_10,                NO_FILTER)       \
+	F(EH12,           FEATURE_INT,    eh12,              EH,         FEAT_EH_11,                NO_FILTER)       \
+	F(EH13,           FEATURE_INT,    eh13,              EH,         FEAT_EH_12,                NO_FILTER)       \
+	F(EH14,           FEATURE_INT,    eh14,              EH,         FEAT_EH_13,                NO_FILTER)       \
+	F(EH15,           FEATURE_INT,    eh15,              EH,         FEAT_EH_14,                NO_FILTER)       \
+	F(EH16,           FEATURE_INT,    eh16,              EH,         FEAT_EH_15,                NO_FILTER)       \
+	F(EHGLOBAL,        FEATURE_INT,    ehGlobal,           EH,         FEAT_EH_16,                EH_GLOBAL)
+
+#define VIDEO_COLUMNS(F) \
+	F(ABRUPTNESS,      FEATURE_FLOAT,  abruptness,         FILE,       FEAT_CAMERA_MOVE,          ABRUPTNESS)      \
+	F(MOTION,          FEATURE_FLOAT,  motion,             FILE,       FEAT_MOTION_MAG,           MOTION)          \
+	F(SHACKINESS,      FEATURE_FLOAT,  shake,              FILE,       FEAT_SHACKINESS,           SHAKE)           \
+	F(FG_AREA,         FEATURE_FLOAT,  fgArea,             FILE,       FEAT_FG_AREA,              FG_AREA)         \
+	F(FOCUS_DIFF,      FEATURE_FLOAT,  focus_dif,          FILE,       FEAT_FOCUS_DIFF,           FOCUS_DIF)       \
+	F(LUMA_STD,        FEATURE_FLOAT,  luminance_std,      FILE,       FEAT_LUMINANCE_STD,        LUMINANCE_STD)   \
+	F(SHADOW,          FEATURE_FLOAT,  shadow,             FILE,       FEAT_SHADOW_AREA,          SHADOW)          \
+	F(RANKSUM,         FEATURE_FLOAT,  ranksum,            FILE,       FEAT_RANK_SUM,             RANKSUM)         \
+	F(PREDICT,         FEATURE_INT,    predict,            FILE,       FEAT_AESTHETIC,            PREDICT)         \
+	F(INTEREST_1,      FEATURE_INT,    interest_1,         FILE,       FEAT_INTEREST,             INTEREST)        \
+	F(SID_1,          FEATURE_INT,    semanticID_1,      SEMANTIC,   NO_FEATURE,                NO_FILTER)       \
+	F(SVALUE_1,       FEATURE_FLOAT,  semanticValue_1,   SEMANTIC,   NO_FEATURE,                NO_FILTER)       \
+	F(SID_2,          FEATURE_INT,    semanticID_2,      SEMANTIC,   NO_FEATURE,                NO_FILTER)       \
+	F(SVALUE_2,       FEATURE_FLOAT,  semanticValue_2,   SEMANTIC,   NO_FEATURE,                NO_FILTER)       \
+	F(SID_3,          FEATURE_INT,    semanticID_3,      SEMANTIC,   NO_FEATURE,                NO_FILTER)       \
+	F(SVALUE_3,       FEATURE_FLOAT,  semanticValue_3,   SEMANTIC,   NO_FEATURE,                NO_FILTER)       \
+	F(SID_4,          FEATURE_INT,    semanticID_4,      SEMANTIC,   NO_FEATURE,                NO_FILTER)       \
+	F(SVALUE_4,       FEATURE_FLOAT,  semanticValue_4,   SEMANTIC,   NO_FEATURE,                NO_FILTER)       \
+	F(SID_5,          FEATURE_INT,    semanticID_5,      SEMANTIC,   NO_FEATURE,                NO_FILTER)       \
+	F(SVALUE_5,       FEATURE_FLOAT,  semanticValue_5,   SEMANTIC,   NO_FEATURE,                NO_FILTER)       \
+	F(A1,             FEATURE_FLOAT,  a1_average_loudness, AUDIO,      NO_FEATURE,                LOUDNESS)       \
+	F(A2,             FEATURE_FLOAT,  a2_dynamic_complexity, AUDIO,      NO_FEATURE,                COMPLEXITY)     \
+	F(A3,             FEATURE_FLOAT,  a3_bpm,            AUDIO,      NO_FEATURE,                BPM)            \
+	F(A4,             FEATURE_FLOAT,  a4_danceability,   AUDIO,      NO_FEATURE,                DANCEABILITY)   \
+	F(A5,             FEATURE_FLOAT,  a5_onset_rate,     AUDIO,      NO_FEATURE,                ONSET)          \
+	F(A6,             FEATURE_FLOAT,  a6_chords_change_rate, AUDIO,      NO_FEATURE,                CHORDS_CHANGE)  \
+	F(A7,             FEATURE_FLOAT,  a7_chords_number_rate, AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(A8,             FEATURE_FLOAT,  a8_key_strength,   AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(A9,             FEATURE_FLOAT,  a9_tuning_diatonic_strength, AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(A10,            FEATURE_FLOAT,  a10_tuning_equal_tempered_deviation, AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(A11,            FEATURE_FLOAT,  a11_tuning_nontempered_energy_ratio, AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC01,         FEATURE_FLOAT,  mfcc01,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC02,         FEATURE_FLOAT,  mfcc02,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC03,         FEATURE_FLOAT,  mfcc03,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC04,         FEATURE_FLOAT,  mfcc04,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC05,         FEATURE_FLOAT,  mfcc05,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC06,         FEATURE_FLOAT,  mfcc06,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC07,         FEATURE_FLOAT,  mfcc07,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC08,         FEATURE_FLOAT,  mfcc08,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC09,         FEATURE_FLOAT,  mfcc09,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC10,         FEATURE_FLOAT,  mfcc10,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC11,         FEATURE_FLOAT,  mfcc11,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC12,         FEATURE_FLOAT,  mfcc12,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(MFCC13,         FEATURE_FLOAT,  mfcc13,            AUDIO,      NO_FEATURE,                NO_FILTER)      \
+	F(CF1,             FEATURE_FLOAT,  cf1,                FILE,       FEAT_COLORFULL_1,          CF1)             \
+	F(CF2,             FEATURE_FLOAT,  cf2,                FILE,       FEAT_COLORFULL_2,          CF2)
+
+//Store and xml accessor of each column type, for the generated code
+#define STORE_GET_FEATURE_INT getInt
+#define STORE_GET_FEATURE_FLOAT getFloat
+#define STORE_GET_FEATURE_STRING getString
+#define STORE_SET_FEATURE_INT setInt
+#define STORE_SET_FEATURE_FLOAT setFloat
+#define STORE_SET_FEATURE_STRING setString
+#define XML_GET_FEATURE_INT getInt
+#define XML_GET_FEATURE_FLOAT getDouble
+#define XML_GET_FEATURE_STRING getString
+
+enum FeatureColumn
+{
+#define FEATURE_COLUMN_ENUM(col, type, member, xml, feature, filter) COL_##col,
+	FILE_COLUMNS(FEATURE_COLUMN_ENUM)
+	VIDEO_COLUMNS(FEATURE_COLUMN_ENUM)
+#undef FEATURE_COLUMN_ENUM
+	COL_COUNT
+};
+
+static_assert(COL_RATE == 6 && COL_SIMILARITY == 10 && COL_REFERENCE == 11 && COL_COUNT == 92,
+	"store columns reordered, journals of older sessions won't replay");
+
+struct FeatureColumnInfo
+{
+	const char *name;
+	FeatureColumnType type;
+};
+
+extern const FeatureColumnInfo featureColumns[COL_COUNT];
+
+//Read side. The file stays mapped while open, values are read in place.
+class FeatureStore
+{
+public:
+	static const uint32_t VERSION = 2;		//Version 1 stores still load
+
+	FeatureStore();
+	~FeatureStore();
+
+	bool open(const std::string &path);		//Map and validate store
+	void close();
+	bool isOpen() const;
+
+	uint32_t size() const;					//Number of rows
+	int rowOf(int fileID) const;			//Binary search in fileID index, -1 if missing
+	bool hasColumn(FeatureColumn c) const;
+
+	int getInt(uint32_t row, FeatureColumn c) const;
+	float getFloat(uint32_t row, FeatureColumn c) const;
+	std::string getString(uint32_t row, FeatureColumn c) const;
+	const float *floatColumn(FeatureColumn c) const;	//Whole column, nullptr if absent or not float
+
+	//In-place update of fixed width cells (rate, similarity...). Row count never changes.
+	bool patchInt(uint32_t row, FeatureColumn c, int value);
+	bool patchFloat(uint32_t row, FeatureColumn c, float value);
+	bool patchString(uint32_t row, FeatureColumn c, const std::string &value);	//Only strings already in dictionary
+	bool sync();							//Patched cells on disk (fsync), true if nothing patched
+
+private:
+	FeatureStore(const FeatureStore &);
+	FeatureStore &operator=(const FeatureStore &);
+
+	bool patchCell(uint32_t row, FeatureColumn c, const void *value);
+	int findString(const std::string &value);
+
+	std::string storePath;
+	MappedFile file;
+	uint32_t rowCount;
+	const char *columns[COL_COUNT];			//Pointer to column block, nullptr if column missing
+	uint64_t columnOffsets[COL_COUNT];
+	const int32_t *index;					//rowCount (fileID,row) pairs sorted by fileID
+	uint32_t stringCount;
+	const uint32_t *stringOffsets;
+	const char *stringData;
+	std::unordered_map<std::string, int> stringIds;		//Built on first patchString
+	FILE *patchFile;						//Opened on first patch
+};
+
+//Write side. Rows are kept in memory and written with commit().
+class FeatureStoreWriter
+{
+public:
+	FeatureStoreWriter();
+
+	void clear();
+	uint32_t addRow();						//Returns index of the new row, all cells 0
+	uint32_t size() const;
+
+	void setInt(uint32_t row, FeatureColumn c, int value);
+	void setFloat(uint32_t row, FeatureColumn c, double value);
+	void setString(uint32_t row, FeatureColumn c, const std::string &value);
+
+	//Writes to path + ".tmp" and renames over path, so a reader never sees half a store.
+	//Committed again to the same path, the rows and strings added since are appended
+	//in place when they fit, and the store is written whole with room to spare when
+	//not. Rows already committed are not written again by an append.
+	bool commit(const std::string &path);
+
+private:
+	uint32_t internString(const std::string &value);
+	void layout(uint32_t rows, uint32_t stringSlots, uint64_t stringBytes);
+	bool rewrite(const std::string &path) const;
+	bool append(uint64_t bytes);
+	void fillHeader(void *out) const;
+	int32_t lastCommittedID() const;
+
+	std::vector<uint32_t> cells[COL_COUNT];		//Raw 4 byte cells, int32 or float bits
+	std::vector<std::string> strings;
+	std::unordered_map<std::string, uint32_t> stringIds;
+
+	//Last commit, and the room its layout has
+	std::string committedPath;
+	uint32_t committedRows;
+	uint32_t committedStrings;
+	uint64_t committedBytes;
+	int32_t maxCommittedID;
+	uint32_t rowCapacity;
+	uint32_t stringCapacity;
+	uint64_t stringByteCapacity;
+	uint64_t columnOffsets[COL_COUNT];
+	uint64_t indexOffset;
+	uint64_t dictionaryOffset;
+	uint64_t stringDataOffset;
+};
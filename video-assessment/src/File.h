@@ -1,6 +1,13 @@
 #pragma once
 
 #include "ofMain.h"
+#include "FeatureStore.h"
+#include "XmlFieldReader.h"
+#include "CsvTable.h"
+#include "FeatureSchema.h"
+#include "MetadataJournal.h"
+
+#include <type_traits>
 
 //using namespace std;
 
@@ -31,6 +38,7 @@ public:
 	ofImage thumbnail;			//Thumbnail
 	string xmlPath;				//Path to metadata file
 	static string xmlFolderPath;//Path to folder with metadata
+	static MetadataJournal *journal;	//Rate updates are queued here, nullptr = write xml
 
 	//Metadata
 	pair<double, double> redMoments;	//First and second red color moment
@@ -68,7 +76,10 @@ public:
 	//virtual string generateThumbnail();			//Generates thumbnails.	
 	virtual bool generateXmlFile();				//Create xml file
 	virtual bool getMetadataFromXml();			//Get data from xml
-	virtual bool getMetadataFromCsv(vector<string> csvData); // csv parse
+	bool getMetadataFromCsv(const CsvTable &csv, int row);	// csv parse, row of output.csv
+	virtual bool getMetadataFromFeatures(int id, const FeatureRecord &features);	//Extracted features of file id
+	virtual bool getMetadataFromStore(const FeatureStore &store, int row);	//Get data from binary store
+	virtual void writeToStore(FeatureStoreWriter &writer, uint32_t row);	//Fill store row
 
 	virtual bool loadThumbnail();				//Load thumbnail from disk to ofImage
 	virtual void setThumbnailPath();			//Sets path to thumbnail	
@@ -77,7 +88,7 @@ public:
 	fileType getType();
 	void rateUpdate(int newRate);				//Update rate field. Update xml file
 
-	void indexUpdate(float newIndex, string newReference);
+	void applyJournalEntry(const JournalEntry &entry);	//Replay an edit saved in the journal
 
 	bool getVisible();
 	void setVisible(bool visibility);
@@ -88,5 +99,31 @@ public:
 
 protected:
 	void setXmlPath();
+	virtual void getMetadataFromXmlFields(const XmlFieldReader &xml);	//Copy parsed xml fields to members
+
+	//Used by the accessors generated from FILE_COLUMNS and VIDEO_COLUMNS
+	//Features not computed (NaN) stay NaN in float members and are -1 in int ones
+	template <typename T>
+	static void copyFeature(T &member, const FeatureRecord &features, VideoFeature feature)
+	{
+		if (feature == NO_FEATURE)
+			return;
+		double value = features[feature];
+		member = std::is_integral<T>::value && value != value ? static_cast<T>(-1) : static_cast<T>(value);
+	}
+	static void copyFeature(string &, const FeatureRecord &, VideoFeature) {}
+	static void setXmlParent(ofXml &xml, const string &element, string &current);
 };
 
+//Accessor bodies, one statement per column: expand with FILE_COLUMNS or VIDEO_COLUMNS
+#define METADATA_FROM_FEATURES(col, type, member, parent, feature, filter) \
+	copyFeature(member, features, feature);
+#define METADATA_FROM_STORE(col, type, member, parent, feature, filter) \
+	if (string(#parent) != "KEY") member = static_cast<decltype(member)>(store.STORE_GET_##type(row, COL_##col));
+#define METADATA_TO_STORE(col, type, member, parent, feature, filter) \
+	writer.STORE_SET_##type(row, COL_##col, member);
+#define METADATA_FROM_XML(col, type, member, parent, feature, filter) \
+	if (string(#parent) != "KEY") member = static_cast<decltype(member)>(xml.XML_GET_##type(#col));
+#define METADATA_TO_XML(col, type, member, parent, feature, filter) \
+	setXmlParent(xml, #parent, current); xml.addValue(#col, member);
+
@@ -0,0 +1,390 @@
+#include "FilterTable.h"
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define FILTER_TABLE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+	//Scalar and 4-wide versions of each comparison
+	struct Equal
+	{
+		static bool scalar(float v, float t) { return v == t; }
+#ifdef FILTER_TABLE_SSE
+		static __m128 simd(__m128 v, __m128 t) { return _mm_cmpeq_ps(v, t); }
+#endif
+	};
+
+	struct NotEqual
+	{
+		static bool scalar(float v, float t) { return v != t; }
+#ifdef FILTER_TABLE_SSE
+		static __m128 simd(__m128 v, __m128 t) { return _mm_cmpneq_ps(v, t); }
+#endif
+	};
+
+	//Bit i set if v[i] passes, for 64 values
+	template <typename Compare>
+	uint64_t compareBlock(const float *v, float threshold)
+	{
+		uint64_t bits = 0;
+#ifdef FILTER_TABLE_SSE
+		__m128 t = _mm_set1_ps(threshold);
+		for (int i = 0; i < 64; i += 4) {
+			__m128 m = Compare::simd(_mm_loadu_ps(v + i), t);
+			bits |= (uint64_t)_mm_movemask_ps(m) << i;
+		}
+#else
+		for (int i = 0; i < 64; ++i) {
+			bits |= (uint64_t)Compare::scalar(v[i], threshold) << i;
+		}
+#endif
+		return bits;
+	}
+
+	unsigned popCount(uint64_t bits)
+	{
+		bits = bits - ((bits >> 1) & 0x5555555555555555ull);
+		bits = (bits & 0x3333333333333333ull) + ((bits >> 2) & 0x3333333333333333ull);
+		bits = (bits + (bits >> 4)) & 0x0f0f0f0f0f0f0f0full;
+		return (unsigned)((bits * 0x0101010101010101ull) >> 56);
+	}
+
+	//Strict order of rows by key, NaN after all numbers, ties by row
+	struct RowBefore
+	{
+		const float *key;
+		bool descending;
+		bool operator()(int a, int b) const
+		{
+			float x = key[a];
+			float y = key[b];
+			bool xNan = x != x;
+			bool yNan = y != y;
+			if (xNan != yNan) return yNan;
+			if (!xNan && x != y) return descending ? x > y : x < y;
+			return a < b;
+		}
+	};
+
+	//NaN is a feature that was not computed, no threshold applies to it
+	bool passes(bool below, float threshold, float value)
+	{
+		if (value != value) return true;
+		return below ? value < threshold : value >= threshold;
+	}
+}
+
+FilterTable::FilterTable() : count(0), stride(0)
+{
+}
+
+void FilterTable::resize(size_t rows)
+{
+	count = rows;
+	stride = (rows + 63) / 64 * 64;
+	values.assign(stride * COLUMNS, 0.0f);
+	orders.assign(COLUMNS, Order());
+	requirements.assign(COLUMNS, Requirement());
+	rejections.assign(rows, 0);
+	showAll();
+	passing = visible;
+}
+
+size_t FilterTable::rows() const
+{
+	return count;
+}
+
+void FilterTable::set(size_t row, Column column, float value)
+{
+	float &v = values[column * stride + row];
+	if (v == value) {
+		return;
+	}
+	const Requirement &r = requirements[column];
+	if (r.active) {
+		bool was = passes(r.below, r.threshold, v);
+		bool now = passes(r.below, r.threshold, value);
+		if (was && !now) reject(row);
+		if (!was && now) accept(row);
+	}
+	v = value;
+	if (!orders[column].rows.empty() && !orders[column].stale) {
+		reposition(column, (int)row);
+	}
+}
+
+float FilterTable::get(size_t row, Column column) const
+{
+	return values[column * stride + row];
+}
+
+const float *FilterTable::column(Column column) const
+{
+	return values.data() + column * stride;
+}
+
+void FilterTable::showAll()
+{
+	visible.assign(stride / 64, ~0ull);
+	if (count % 64 != 0) {
+		visible.back() = (1ull << (count % 64)) - 1;	//Padding rows stay hidden
+	}
+}
+
+void FilterTable::hideAll()
+{
+	visible.assign(stride / 64, 0);
+}
+
+void FilterTable::show(size_t row)
+{
+	visible[row / 64] |= 1ull << (row % 64);
+}
+
+void FilterTable::hide(size_t row)
+{
+	visible[row / 64] &= ~(1ull << (row % 64));
+}
+
+bool FilterTable::isVisible(size_t row) const
+{
+	return (visible[row / 64] >> (row % 64)) & 1;
+}
+
+size_t FilterTable::visibleCount() const
+{
+	size_t n = 0;
+	for (size_t w = 0; w < visible.size(); ++w) {
+		n += popCount(visible[w]);
+	}
+	return n;
+}
+
+const vector<uint64_t> &FilterTable::visibleWords() const
+{
+	return visible;
+}
+
+template <typename Compare>
+void FilterTable::filter(Column column, float value)
+{
+	const float *v = values.data() + column * stride;
+	for (size_t w = 0; w < visible.size(); ++w) {
+		if (visible[w] != 0) {				//Nothing left to hide in empty words
+			visible[w] &= compareBlock<Compare>(v + w * 64, value);
+		}
+	}
+}
+
+void FilterTable::equal(Column column, float value)
+{
+	filter<Equal>(column, value);
+}
+
+void FilterTable::notEqual(Column column, float value)
+{
+	filter<NotEqual>(column, value);
+}
+
+void FilterTable::requireAtLeast(Column column, float threshold)
+{
+	require(column, false, threshold);
+}
+
+void FilterTable::requireBelow(Column column, float threshold)
+{
+	require(column, true, threshold);
+}
+
+void FilterTable::require(Column column, bool below, float threshold)
+{
+	Requirement &r = requirements[column];
+	if (r.active && r.below == below && r.threshold == threshold) {
+		return;
+	}
+	const float *v = values.data() + column * stride;
+	if (!r.active || r.below != below) {		//New filter: one pass over the column
+		for (size_t i = 0; r.active && i < count; ++i) {
+			if (!passes(r.below, r.threshold, v[i])) accept(i);
+		}
+		r.active = true;
+		r.below = below;
+		r.threshold = threshold;
+		for (size_t i = 0; i < count; ++i) {
+			if (!passes(below, threshold, v[i])) reject(i);
+		}
+		return;
+	}
+
+	//Only rows between the two cuts can change side
+	Order &order = orders[column];
+	if (order.rows.empty()) {
+		buildOrder(column);
+	}
+	else if (order.stale) {
+		sortOrder(column);
+	}
+	size_t from = cut(column, r.threshold);
+	size_t to = cut(column, threshold);
+	for (size_t i = min(from, to); i < max(from, to); ++i) {
+		int row = order.rows[i];
+		bool was = passes(below, r.threshold, v[row]);
+		bool now = passes(below, threshold, v[row]);
+		if (was && !now) reject(row);
+		if (!was && now) accept(row);
+	}
+	r.threshold = threshold;
+}
+
+//Rows before the cut have value >= threshold (descending order) or < threshold (ascending)
+size_t FilterTable::cut(Column column, float threshold) const
+{
+	const Order &order = orders[column];
+	const float *v = values.data() + column * stride;
+	auto first = partition_point(order.rows.begin(), order.rows.end(), [&](int row) {
+		return order.descending ? v[row] >= threshold : v[row] < threshold;
+	});
+	return first - order.rows.begin();
+}
+
+void FilterTable::reject(size_t row)
+{
+	if (rejections[row]++ == 0) {
+		passing[row / 64] &= ~(1ull << (row % 64));
+	}
+}
+
+void FilterTable::accept(size_t row)
+{
+	if (--rejections[row] == 0) {
+		passing[row / 64] |= 1ull << (row % 64);
+	}
+}
+
+void FilterTable::showPassing()
+{
+	visible = passing;
+}
+
+void FilterTable::intersect(const vector<uint64_t> &words)
+{
+	for (size_t w = 0; w < visible.size(); ++w) {
+		visible[w] &= w < words.size() ? words[w] : 0;
+	}
+}
+
+void FilterTable::subtract(const vector<uint64_t> &words)
+{
+	for (size_t w = 0; w < visible.size() && w < words.size(); ++w) {
+		visible[w] &= ~words[w];
+	}
+}
+
+void FilterTable::buildOrder(Column column, bool descending)
+{
+	Order &order = orders[column];
+	order.rows.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		order.rows[i] = (int)i;
+	}
+	order.position.resize(count);
+	order.descending = descending;
+	sortOrder(column);
+}
+
+void FilterTable::sortOrder(Column column)
+{
+	Order &order = orders[column];
+	RowBefore before = { values.data() + column * stride, order.descending };
+	sort(order.rows.begin(), order.rows.end(), before);
+	for (size_t i = 0; i < order.rows.size(); ++i) {
+		order.position[order.rows[i]] = (int)i;
+	}
+	order.stale = false;
+	order.work = 0;
+}
+
+//Move one edited row to its new place, shifting the rows in between by one
+void FilterTable::reposition(Column column, int row)
+{
+	Order &order = orders[column];
+	RowBefore before = { values.data() + column * stride, order.descending };
+	vector<int> &rows = order.rows;
+	int from = order.position[row];
+	int first, last;
+	if (from > 0 && before(row, rows[from - 1])) {
+		int to = (int)(lower_bound(rows.begin(), rows.begin() + from, row, before) - rows.begin());
+		rotate(rows.begin() + to, rows.begin() + from, rows.begin() + from + 1);
+		first = to;
+		last = from;
+	}
+	else if (from + 1 < (int)rows.size() && before(rows[from + 1], row)) {
+		int to = (int)(lower_bound(rows.begin() + from + 1, rows.end(), row, before) - rows.begin());
+		rotate(rows.begin() + from, rows.begin() + from + 1, rows.begin() + to);
+		first = from;
+		last = to - 1;
+	}
+	else {
+		return;
+	}
+	for (int i = first; i <= last; ++i) {
+		order.position[rows[i]] = i;
+	}
+
+	//Past the cost of a sort (bulk edits), stop moving rows and sort on next use
+	order.work += last - first + 1;
+	if (order.work > count * 16) {
+		order.stale = true;
+	}
+}
+
+void FilterTable::ranked(Column column, size_t limit, vector<int> &rows)
+{
+	rows.clear();
+	Order &order = orders[column];
+	if (order.rows.empty()) {
+		buildOrder(column);
+	}
+	else if (order.stale) {
+		sortOrder(column);
+	}
+	const float *v = values.data() + column * stride;
+	for (size_t i = 0; i < order.rows.size() && rows.size() < limit; ++i) {
+		int row = order.rows[i];
+		if (v[row] != v[row]) {
+			break;							//NaN rows are last and not ranked
+		}
+		if (isVisible(row)) {
+			rows.push_back(row);
+		}
+	}
+}
+
+unsigned FilterTable::lowestBit(uint64_t bits)
+{
+#if defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, bits);
+	return (unsigned)index;
+#elif defined(_MSC_VER)
+	unsigned long index;						//Win32 builds: no 64-bit scan, low half then high half
+	if (_BitScanForward(&index, (unsigned long)bits)) {
+		return (unsigned)index;
+	}
+	_BitScanForward(&index, (unsigned long)(bits >> 32));
+	return (unsigned)index + 32;
+#else
+	return (unsigned)__builtin_ctzll(bits);
+#endif
+}
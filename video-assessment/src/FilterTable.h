@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Filterable attributes of all files as contiguous float columns, and which rows
+//pass the filters as a bitset. Threshold filters are evaluated a column at a
+//time, 64 rows per bitset word (SSE compares where available).
+class FilterTable
+{
+public:
+	enum Column
+	{
+		RED_RATIO,
+		GREEN_RATIO,
+		BLUE_RATIO,
+		RATE,
+		ENTROPY,
+		LUMINANCE,
+		SHARPNESS,
+		ABRUPTNESS,
+		MOTION,
+		LUMINANCE_STD,
+		DIF_HUES,
+		STATIC_SALIENCY,
+		CF1,
+		CF2,
+		RANKSUM,
+		SHADOW,
+		AVG_FACES,
+		FACE_AREA,
+		SMILES,
+		FG_AREA,
+		FOCUS_DIF,
+		SHAKE,
+		RULE3,
+		LOUDNESS,
+		COMPLEXITY,
+		BPM,
+		DANCEABILITY,
+		ONSET,
+		CHORDS_CHANGE,
+		HUMAN_FACE,
+		PREDICT,
+		INTEREST,
+		EH_GLOBAL,
+		SIMILARITY,
+		FILE_ID,
+		COLUMNS,
+		NO_FILTER = COLUMNS						//Store column not filterable, see FILE_COLUMNS
+	};
+
+	FilterTable();
+
+	void resize(size_t rows);					//Values 0, all rows visible
+	size_t rows() const;
+	void set(size_t row, Column column, float value);	//Also moves the row in the column order
+	float get(size_t row, Column column) const;
+	const float *column(Column column) const;	//rows() values
+
+	//Visibility
+	void showAll();
+	void hideAll();
+	void show(size_t row);
+	void hide(size_t row);
+	bool isVisible(size_t row) const;
+	size_t visibleCount() const;
+	const std::vector<uint64_t> &visibleWords() const;	//Bit r % 64 of word r / 64
+
+	//Standing threshold filters, at most one per column. They stay set between
+	//calls: each row counts the ones it fails, and moving a threshold only
+	//revisits the rows between the old and new cut in the column order.
+	//NaN values (features not computed) pass every threshold.
+	void requireAtLeast(Column column, float threshold);
+	void requireBelow(Column column, float threshold);
+	void showPassing();							//visible = rows that fail no standing filter
+
+	//visible &= value <op> threshold, for every row
+	void equal(Column column, float value);
+	void notEqual(Column column, float value);
+	void intersect(const std::vector<uint64_t> &words);	//visible &= words, same layout as visibleWords
+	void subtract(const std::vector<uint64_t> &words);	//visible &= ~words
+
+	//Row order by a column, highest first (lowest if !descending), ties by row, NaN last.
+	//Built once, then kept by set(); bulk edits mark it for a rebuild instead.
+	void buildOrder(Column column, bool descending = true);
+	void ranked(Column column, size_t limit, std::vector<int> &rows);	//Visible rows in column order, at most limit, no NaN
+
+	template <typename Function>
+	void forEachVisible(Function f) const		//f(row) in row order
+	{
+		for (size_t w = 0; w < visible.size(); ++w) {
+			uint64_t bits = visible[w];
+			while (bits) {
+				unsigned bit = lowestBit(bits);
+				f(w * 64 + bit);
+				bits &= bits - 1;
+			}
+		}
+	}
+
+	static unsigned lowestBit(uint64_t bits);	//bits != 0
+
+private:
+	struct Order
+	{
+		std::vector<int> rows;					//Rows sorted by the column, empty if not kept
+		std::vector<int> position;				//Index of each row in rows
+		bool descending;
+		bool stale;								//Edited too much, sort again before use
+		size_t work;							//Elements moved since the last sort
+	};
+
+	struct Requirement
+	{
+		bool active;
+		bool below;								//value < threshold, else value >= threshold
+		float threshold;
+	};
+
+	template <typename Compare>
+	void filter(Column column, float value);
+	void require(Column column, bool below, float threshold);
+	size_t cut(Column column, float threshold) const;
+	void reject(size_t row);
+	void accept(size_t row);
+	void sortOrder(Column column);
+	void reposition(Column column, int row);
+
+	size_t count;
+	size_t stride;								//count rounded up to 64
+	std::vector<float> values;					//Column after column, stride values each
+	std::vector<uint64_t> visible;
+	std::vector<Order> orders;					//One per column
+	std::vector<Requirement> requirements;		//One per column
+	std::vector<uint8_t> rejections;			//Standing filters each row fails
+	std::vector<uint64_t> passing;				//Rows with no rejection, as visible
+};
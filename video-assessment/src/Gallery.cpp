@@ -1,12 +1,10 @@
 #include "Gallery.h"
 #include <opencv2/opencv.hpp>
 #include <opencv/highgui.h>
-#include <json.hpp>
 
 using namespace cv;
 
 using namespace std::chrono;
-using json = nlohmann::json;
 
 Gallery::Gallery() {
 	panelWidth = 1;
@@ -34,23 +32,23 @@ void Gallery::test()
 
 void Gallery::setup()
 {
+	bool extract = false;						//Extraction started at the end of setup, files shown as they are done
 
 	if (!isLocked()) {
 
 		getConfigParams();
+		remove(thumbnailArchivePath.c_str());		//Thumbnails are extracted again, the archive is rebuilt from them
 
 		if (!parseOnly) {
-			extractVideoData();
+			extract = true;
+		}
+		else {
+			extractVideoThumbnails();
+			lock();
 		}
-		else extractVideoThumbnails();
-
-		parseCsvFeatureVector();
-		parseSemanticVector();
-		parseAudioVector();
-		lock();
 	}
 
-	if (!loadFiles())
+	if (!extract && !loadFiles())
 	{
 		std::cout << "Load files error" << endl;
 		::ofExit(1);
@@ -80,9 +78,11 @@ void Gallery::setup()
 	videoPreviewClicked = false;
 	thumbnailsWidth = File::thumbnailWidth;
 	thumbnailsHeight = File::thumbnailHeight;
-	for (int i = 0; i < allFiles.size(); ++i) {
-		rectangles.push_back(ofRectangle(0, 0, thumbnailsWidth, thumbnailsHeight));
+	layout.setCell(thumbnailsWidth, thumbnailsHeight, gap);
+	if (!allFiles.empty()) {
+		filtersPanel.setFiles(&allFiles[0], allFiles.size());	//Also the display order used by update
 	}
+	layoutVersion = filtersPanel.displayVersion() - 1;	//First update lays out
 
 	Gallery::update();				//To get all coordinates properly
 
@@ -98,6 +98,9 @@ void Gallery::setup()
 	//Initialize filters
 	filtersPanel.setup();
 	videoPlay = false;
+	previews = new PreviewPool();
+	if (extract)
+		startExtraction();
 	cout << "------------------------------------------------------------------" << endl;
 }
 
@@ -110,35 +113,29 @@ void Gallery::update()
 	// Space available for displayed rectangles
 	availableWidth = panelWidth - scrollBarWidth - gap;
 
-	// Coordinates for first rectangle
-	int x = 0;
-	int y = 0;
-
-	ofRectangle * r;
-	r = new ofRectangle(0, 0, 0, 0);	//Initialize required if no picture is visible
-
-	// Place the rectangles in rows and columns. A row must be smaller than availableWidth
-	// After this loop, we know that the rectangles fits the panel width. But the available panel height can be to small to display them all.
-	for (int i = 0; i < allFiles.size(); ++i) {	//For all visible files
-		if (allFiles[i].getVisible()) {
-			r = &rectangles[i];
-			r->x = x;
-			r->y = y;
-
-			// Now compute the next rectangle position
-			x += thumbnailsWidth + gap;
-			if (x + thumbnailsWidth > availableWidth) {
-				scrollBarRectangle.x = r->getRight() + gap; // Adjust the scroll bar position to draw it just at the right
-				x = 0;
-				y += thumbnailsHeight + gap;
+	// Rectangles in rows and columns, a row smaller than availableWidth. Positions are computed
+	// from the column count, so only a change of the visible files or their order needs a pass
+	layout.setWidth(availableWidth);
+	if (extraction != nullptr)
+		addExtractedFiles();
+	if (filtersPanel.displayVersion() != layoutVersion) {
+		const vector<int> &order = filtersPanel.displayOrder();
+		vector<int> items;
+		for (int k = 0; k < order.size(); ++k) {
+			if (allFiles[order[k]].getVisible()) {
+				items.push_back(order[k]);
 			}
 		}
+		layout.setItems(items);
+		layoutVersion = filtersPanel.displayVersion();
+	}
+	if (layout.size() >= layout.columns()) {
+		scrollBarRectangle.x = layout.columns() * (thumbnailsWidth + gap); // Adjust the scroll bar position to draw it just at the right
 	}
 
 	gripRectangle.x = scrollBarRectangle.x; // Also adjust the grip x coordinate
 
-	int contentHeight = r->getBottom(); // Total height for all the rectangles
-										// TODO: take care if colors.size() == 0
+	int contentHeight = layout.contentHeight(); // Total height for all the rectangles
 
 	if (contentHeight > panelHeight) {
 		/* In the case where there's not enough room to display all the rectangles */
@@ -183,6 +180,26 @@ void Gallery::update()
 	}
 	fileSpace = spaceForFileDisplay();
 
+	// Thumbnails wanted: the ones in view, then a screen below and a screen above
+	if (thumbnails != nullptr) {
+		size_t first, last, before, after;
+		layout.itemsInView(contentScrollY, panelHeight, first, last);
+		layout.itemsInView(max(0, contentScrollY - panelHeight), 3 * panelHeight, before, after);
+		vector<int> wanted;
+		for (size_t k = first; k < last; ++k)
+			wanted.push_back(layout.item(k));
+		for (size_t k = last; k < after; ++k)
+			wanted.push_back(layout.item(k));
+		for (size_t k = first; k-- > before;)
+			wanted.push_back(layout.item(k));
+		thumbnails->request(wanted);
+		thumbnails->update();		// upload the decoded ones
+	}
+	if (previews != nullptr) {
+		previews->setPlaying(videoPlay);
+		previews->update();
+	}
+
 }
 
 void Gallery::draw()
@@ -195,152 +212,149 @@ void Gallery::draw()
 	ofTranslate(margin, topMargin, 0);
 
 	ofRectangle r;
-	ofImage img;
 	//ofSetColor(0);
-	numberOfselectedFiles = 0;
+	numberOfselectedFiles = layout.size();
+
+	size_t first, last;
+	layout.itemsInView(contentScrollY, panelHeight, first, last);
+	ThumbnailAtlas &atlas = thumbnails->atlas();
+	atlas.begin();					//Thumbnails are queued here and drawn together after the frames
+	for (size_t k = first; k < last; ++k) {	//Only the visible files that reach the panel
+		int i = layout.item(k);
+		r = ofRectangle(layout.x(k), layout.y(k), thumbnailsWidth, thumbnailsHeight);	// the rectangle position in the panel
+		r.y -= contentScrollY;			// adjust this position according to the scrolling
+		int slot = thumbnails->slot(i);	// -1 until decoded, the black rectangle stands in
+		int dif = slot < 0 ? 0 : (thumbnailsHeight - atlas.height(slot)) / 2;	// centered, on whole pixels
+
+		if (r.y < 0) {
+			if (r.getBottom() > 0) {
+				// Exception 1: If a rectangle is cut at the top of the panel
 
+				if (allFiles[i].rate == 1) {
 
-	for (int i = 0; i < allFiles.size(); ++i) {	//For all visible files
-		if (allFiles[i].getVisible()) {
-			numberOfselectedFiles++;
-			r = rectangles[i];				// the rectangle position in the panel
-			r.y -= contentScrollY;			// adjust this position according to the scrolling
-			img = allFiles[i].thumbnail;    // image to display. OF don't copy big objects like ofImage, so no need to use a pointer.			
+					ofSetColor(0, 255, 0);  // Set the drawing color to yellow							
+					ofDrawRectangle(r.x - 3, -3, thumbnailsWidth + 6, thumbnailsHeight + r.y + 16);
+					ofSetColor(255);
 
-			if (r.y < 0) {
-				if (r.getBottom() > 0) {
-					// Exception 1: If a rectangle is cut at the top of the panel
+				}
+				if (allFiles[i].rate == 2) {
 
-					if (allFiles[i].rate == 1) {
+					ofSetColor(0, 0, 255);  // Set the drawing color to yellow							
+					ofDrawRectangle(r.x - 3, -3, thumbnailsWidth + 6, thumbnailsHeight + r.y + 16);
+					ofSetColor(255);
 
-						ofSetColor(0, 255, 0);  // Set the drawing color to yellow							
-						ofDrawRectangle(r.x - 3, -3, thumbnailsWidth + 6, thumbnailsHeight + r.y + 16);
-						ofSetColor(255);
+				}
+				if (allFiles[i].rate == 3) {
 
-					}
-					if (allFiles[i].rate == 2) {
+					ofSetColor(255, 0, 0);  // Set the drawing color to yellow							
+					ofDrawRectangle(r.x - 3, -3, thumbnailsWidth + 6, thumbnailsHeight + r.y + 16);
+					ofSetColor(255);
 
-						ofSetColor(0, 0, 255);  // Set the drawing color to yellow							
-						ofDrawRectangle(r.x - 3, -3, thumbnailsWidth + 6, thumbnailsHeight + r.y + 16);
-						ofSetColor(255);
+				}
+				if (allFiles[i].getIsCurrentFile()) {
 
-					}
-					if (allFiles[i].rate == 3) {
+					ofSetColor(255, 255, 0);  // Set the drawing color to yellow							
+					ofDrawRectangle(r.x - 3, -3, thumbnailsWidth + 6, thumbnailsHeight + r.y + 16);
+					ofSetColor(255);
 
-						ofSetColor(255, 0, 0);  // Set the drawing color to yellow							
-						ofDrawRectangle(r.x - 3, -3, thumbnailsWidth + 6, thumbnailsHeight + r.y + 16);
-						ofSetColor(255);
+				}
 
-					}
-					if (allFiles[i].getIsCurrentFile()) {
+				ofSetColor(0);
+				ofDrawRectangle(r.x, 0, thumbnailsWidth, thumbnailsHeight + r.y + 10); 	// Draw black rectangle
+				ofSetColor(255);
+				atlas.addQuad(slot, r.x, r.y + dif, 0, panelHeight);	// clipped at the top of the panel
+				name->drawString(allFiles[i].name.substr(0, 16), r.x + 3, r.y + thumbnailsHeight + 0.5*gap);
 
-						ofSetColor(255, 255, 0);  // Set the drawing color to yellow							
-						ofDrawRectangle(r.x - 3, -3, thumbnailsWidth + 6, thumbnailsHeight + r.y + 16);
-						ofSetColor(255);
+			}
+		}
+		else if (r.getBottom() >= panelHeight) {
+			if (r.y <= panelHeight) {
 
-					}
+				if (allFiles[i].rate == 1) {
 
-					ofSetColor(0);
-					ofDrawRectangle(r.x, 0, thumbnailsWidth, thumbnailsHeight + r.y + 10); 	// Draw black rectangle
+					ofSetColor(0, 255, 0);  // Set the drawing color to yellow							
+					ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, panelHeight + 6 - r.y);
 					ofSetColor(255);
-					img.resize(r.width, r.height - 2 * gap);
-
-					img.getTextureReference().drawSubsection(r.x, 0, r.width, thumbnailsHeight + r.y - 2 * gap, 0, -r.y, r.width, thumbnailsHeight + r.y - 2 * gap);
-					name->drawString(allFiles[i].name.substr(0, 16), r.x + 3, r.y + thumbnailsHeight + 0.5*gap);
 
 				}
-			}
-			else if (r.getBottom() >= panelHeight) {
-				if (r.y <= panelHeight) {
-
-					if (allFiles[i].rate == 1) {
-
-						ofSetColor(0, 255, 0);  // Set the drawing color to yellow							
-						ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, panelHeight + 6 - r.y);
-						ofSetColor(255);
-
-					}
-					if (allFiles[i].rate == 2) {
-
-						ofSetColor(0, 0, 255);  // Set the drawing color to yellow							
-						ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, panelHeight + 6 - r.y);
-						ofSetColor(255);
+				if (allFiles[i].rate == 2) {
 
-					}
-					if (allFiles[i].rate == 3) {
+					ofSetColor(0, 0, 255);  // Set the drawing color to yellow							
+					ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, panelHeight + 6 - r.y);
+					ofSetColor(255);
 
-						ofSetColor(255, 0, 0);  // Set the drawing color to yellow							
-						ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, panelHeight + 6 - r.y);
-						ofSetColor(255);
+				}
+				if (allFiles[i].rate == 3) {
 
-					}
-					if (allFiles[i].getIsCurrentFile()) {
+					ofSetColor(255, 0, 0);  // Set the drawing color to yellow							
+					ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, panelHeight + 6 - r.y);
+					ofSetColor(255);
 
-						ofSetColor(255, 255, 0);  // Set the drawing color to yellow							
-						ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, panelHeight + 6 - r.y);
-						ofSetColor(255);
+				}
+				if (allFiles[i].getIsCurrentFile()) {
 
-					}
-					ofSetColor(0);
-					ofDrawRectangle(r.x, r.y, thumbnailsWidth, panelHeight - r.y);
+					ofSetColor(255, 255, 0);  // Set the drawing color to yellow							
+					ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, panelHeight + 6 - r.y);
 					ofSetColor(255);
-					img.resize(r.width, r.height - 2 * gap);
-					// Exception 2: If a rectangle is cut at the bottom of the panel.				
-					img.getTextureReference().drawSubsection(r.x, r.y + gap, r.width, img.getHeight() - gap, 0, gap, r.width, img.getHeight() - gap);
-					name->drawString(allFiles[i].name.substr(0, 16), r.x + 3, r.y + thumbnailsHeight - 0.5*gap);
 
 				}
-			}
-			else {
-				// Draw a rectangle in the panel
+				ofSetColor(0);
+				ofDrawRectangle(r.x, r.y, thumbnailsWidth, panelHeight - r.y);
+				ofSetColor(255);
+				// Exception 2: If a rectangle is cut at the bottom of the panel.				
+				atlas.addQuad(slot, r.x, r.y + dif, 0, panelHeight);
+				name->drawString(allFiles[i].name.substr(0, 16), r.x + 3, r.y + thumbnailsHeight - 0.5*gap);
 
-				if (allFiles[i].rate == 1) {
+			}
+		}
+		else {
+			// Draw a rectangle in the panel
 
-					ofSetColor(0, 255, 0);  // Set the drawing color to green						
-					ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, thumbnailsHeight + 16); 	// Draw white rectangle
-					ofSetColor(0);
+			if (allFiles[i].rate == 1) {
 
-				}
-				if (allFiles[i].rate == 2) {
+				ofSetColor(0, 255, 0);  // Set the drawing color to green						
+				ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, thumbnailsHeight + 16); 	// Draw white rectangle
+				ofSetColor(0);
 
-					ofSetColor(0, 0, 255);  // Set the drawing color to blue						
-					ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, thumbnailsHeight + 16); 	// Draw white rectangle
-					ofSetColor(0);
+			}
+			if (allFiles[i].rate == 2) {
 
-				}
-				if (allFiles[i].rate == 3) {
+				ofSetColor(0, 0, 255);  // Set the drawing color to blue						
+				ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, thumbnailsHeight + 16); 	// Draw white rectangle
+				ofSetColor(0);
 
-					ofSetColor(255, 0, 0);  // Set the drawing color to red						
-					ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, thumbnailsHeight + 16); 	// Draw white rectangle
-					ofSetColor(0);
+			}
+			if (allFiles[i].rate == 3) {
 
-				}
-				if (allFiles[i].getIsCurrentFile()) {
+				ofSetColor(255, 0, 0);  // Set the drawing color to red						
+				ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, thumbnailsHeight + 16); 	// Draw white rectangle
+				ofSetColor(0);
 
-					ofSetColor(255, 255, 255);  // Set the drawing color to white						
-					ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, thumbnailsHeight + 16); 	// Draw white rectangle
-					ofSetColor(0);
+			}
+			if (allFiles[i].getIsCurrentFile()) {
 
-				}
+				ofSetColor(255, 255, 255);  // Set the drawing color to white						
+				ofDrawRectangle(r.x - 3, r.y - 3, thumbnailsWidth + 6, thumbnailsHeight + 16); 	// Draw white rectangle
+				ofSetColor(0);
 
-				ofSetColor(0);  // Set the drawing color to black							
-				ofDrawRectangle(r.x, r.y, thumbnailsWidth, thumbnailsHeight + 10); 	// Draw black rectangle
-				ofSetColor(255);
+			}
 
-				float dif = (thumbnailsHeight - allFiles[i].thumbnail.getHeight()) / 2;
-				allFiles[i].thumbnail.draw(r.x, r.y + dif);
+			ofSetColor(0);  // Set the drawing color to black							
+			ofDrawRectangle(r.x, r.y, thumbnailsWidth, thumbnailsHeight + 10); 	// Draw black rectangle
+			ofSetColor(255);
 
-				name->drawString(allFiles[i].name.substr(0, 16), r.x + 3, r.y + thumbnailsHeight + 0.5*gap);
+			atlas.addQuad(slot, r.x, r.y + dif, 0, panelHeight);
 
-			}
+			name->drawString(allFiles[i].name.substr(0, 16), r.x + 3, r.y + thumbnailsHeight + 0.5*gap);
 
-			rectangles[i] = r;
 		}
 
 		//if (i == allFiles.size() - 1)
 			//counter->drawString(ofToString(numberOfselectedFiles) + " / " + ofToString(allFiles.size()), 2, 600);
 
 	}
+	ofSetColor(255);
+	atlas.draw();					// one draw per atlas page in view
 
 	/* Draw the scroll bar, if needed */
 
@@ -362,7 +376,12 @@ void Gallery::draw()
 	//filtersPanel
 	filtersPanel.draw();
 	ofSetColor(255);
-	counter->drawString(ofToString(numberOfselectedFiles) + " / " + ofToString(allFiles.size()), metadataPanel.getCordX(), 40);
+	string count = ofToString(numberOfselectedFiles) + " / " + ofToString(allFiles.size());
+	counter->drawString(count, metadataPanel.getCordX(), 40);
+	if (extraction != nullptr) {
+		playerText->drawString("extracting " + ofToString(extraction->processed()) + " / " + ofToString(extraction->total()),
+			metadataPanel.getCordX() + counter->stringWidth(count) + 20, 40);
+	}
 	//Draw metadata on when clicked
 	if (thumbnailClicked) {
 		int metadataPanel_x = scrollBarRectangle.x + scrollBarWidth + 1.5*margin;		//x coordinate of metadata panel 
@@ -371,7 +390,7 @@ void Gallery::draw()
 
 		if (allFiles[choosenFileIndex].getType() == File::fileType::VIDEO)	//Video file choosen
 		{
-			choosenVideo.draw(fileSpace, videoPlay, playerText);
+			previews->draw(fileSpace, playerText);
 		}
 		else
 		{
@@ -380,6 +399,25 @@ void Gallery::draw()
 	}
 }
 
+//Write queued rate edits before the app closes
+void Gallery::exit()
+{
+	if (extraction != nullptr) {
+		cout << " [*] Extraction cancelled, waiting for the clip being processed" << endl;
+		delete extraction;			// not locked, extracted again on the next start
+		extraction = nullptr;
+	}
+	File::journal = nullptr;
+	if (journal != nullptr)
+		journal->close();
+	delete thumbnailAppender;		// keeps the thumbnails appended so far
+	thumbnailAppender = nullptr;
+	delete thumbnails;				// stops the decoding threads
+	thumbnails = nullptr;
+	delete previews;
+	previews = nullptr;
+}
+
 void Gallery::keyPressed(int key)
 {
 	//cout << char(key);
@@ -450,6 +488,7 @@ void Gallery::mousePressed(int x, int y, int button) {
 			{
 				cout << "Index: " << choosenFileIndex << " Rate: " << filtersPanel.getGroup() << endl;
 				allFiles[choosenFileIndex].rateUpdate(filtersPanel.getGroup());	//Update its rate
+				filtersPanel.updateFile(choosenFileIndex, allFiles[choosenFileIndex]);
 
 			}
 
@@ -458,6 +497,7 @@ void Gallery::mousePressed(int x, int y, int button) {
 		{
 			for (int i = 0; i < allFiles.size(); ++i) {	//For all  files
 				allFiles[i].rateUpdate(0);
+				filtersPanel.updateFile(i, allFiles[i]);
 			}
 		}
 	}
@@ -509,7 +549,8 @@ void Gallery::mousePressed(int x, int y, int button) {
 			if (allFiles[choosenFileIndex].getType() == File::fileType::VIDEO)		//Video file choosen
 			{
 				videoPlay = false;
-				choosenVideo = VideoFile(&allFiles[choosenFileIndex]);
+				choosenVideo = allFiles[choosenFileIndex];		//Metadata only, the clip is opened by previews
+				selectPreview(choosenFileIndex);
 
 				for (int i = 0; i < allFiles.size(); ++i) {	//For all  files
 					allFiles[i].setIsCurrentFile(false);
@@ -543,8 +584,8 @@ void Gallery::mousePressed(int x, int y, int button) {
 void Gallery::mouseReleased(int x, int y, int button) {
 	isDraggingGrip = false;
 
-	if (filtersPanel.isSimpleFiltersClicked(x, y) || filtersPanel.isAdvancedFiltersClicked(x, y) || filtersPanel.isSortClicked(x, y)
-		|| filtersPanel.isModifyClicked(x, y))
+	if ((filtersPanel.isSimpleFiltersClicked(x, y) || filtersPanel.isAdvancedFiltersClicked(x, y) || filtersPanel.isSortClicked(x, y)
+		|| filtersPanel.isModifyClicked(x, y)) && !allFiles.empty())	//Empty until the first clip is extracted
 	{
 		high_resolution_clock::time_point t1 = high_resolution_clock::now(); // note time before execution
 		filtersPanel.filter(&allFiles[0], allFiles.size(), choosenFileIndex);
@@ -655,7 +696,7 @@ bool Gallery::extractVideoThumbnails() {
 
 	return true;
 }
-bool Gallery::extractVideoData() {
+bool Gallery::extractVideoData(ExtractionQueue *queue) {
 
 
 	cout << " [*] COGNITUS visual feature extraction module" << endl;
@@ -670,6 +711,8 @@ bool Gallery::extractVideoData() {
 	glob(inputFolder.c_str(), fileNames); // loads path to filenames into vector
 	nFiles = fileNames.size();
 	cout << " [!] number of files to process: " << nFiles << "\n\n";
+	if (queue != nullptr)
+		queue->setTotal(nFiles);
 
 	//Save metadata to the output csv file
 	ofstream myfile(dataOutputPath.c_str());
@@ -677,13 +720,22 @@ bool Gallery::extractVideoData() {
 	ofstream mysemanticfile(semanticDataOutputPath.c_str());
 	//for audio
 	ofstream myaudiofile(audioDataOutputPath.c_str());
+	//and the binary store the gallery loads from
+	FeatureStoreWriter storeWriter;
+	int uncommittedRows = 0;			//Rows added since the last commit
 
 	///main loop
 	int nv = 0;
 	int aesthetic = 0;
 	int interest = 0;
+	bool cancelled = false;
 	while (nv < nFiles)
 	{
+		if (queue != nullptr && queue->isCancelled()) {
+			cout << " [!] extraction cancelled after " << nv << " files" << endl;
+			cancelled = true;
+			break;
+		}
 		auto start = chrono::high_resolution_clock::now();
 		ex.extractFromVideo(fileNames.at(nv), nv + 1);
 
@@ -692,23 +744,7 @@ bool Gallery::extractVideoData() {
 		semanticTemp = ex.getSemanticMap();
 
 		if (mysemanticfile.is_open()) {
-
-			int x = 0;
-
-			while (x < semanticTemp.size()) {
-
-				if (x != semanticTemp.size() - 1) {
-
-					mysemanticfile << semanticTemp.at(x).second << ","
-						<< semanticTemp.at(x).first << ",";
-				}
-				else {
-					mysemanticfile << semanticTemp.at(x).second << ","
-						<< semanticTemp.at(x).first;
-				}
-				x++;
-			}
-			mysemanticfile << "\n";
+			mysemanticfile << formatSemanticRow(semanticTemp) << "\n";
 			mysemanticfile.flush();
 		}
 
@@ -716,148 +752,56 @@ bool Gallery::extractVideoData() {
 
 		audioTemp = ex.getAudioMap();
 
-		if (myaudiofile.is_open()) {
-
-			int xi = 0;
-
-			while (xi < audioTemp.size()) {
-
-				if (xi != audioTemp.size() - 1) {
-					myaudiofile << audioTemp.at(xi) << ",";
-				}
-				else {
-					myaudiofile << audioTemp.at(xi) << "\n";
-				}
-				xi++;
-			}
-			//myaudiofile << "\n";
+		if (myaudiofile.is_open() && !audioTemp.empty()) {	//No line when audio is not extracted
+			myaudiofile << formatAudioRow(audioTemp) << "\n";
 			myaudiofile.flush();
 		}
-		json jsonA = ex.getJsonA();
-
-		json jsonI = ex.getJsonI();
+		FeatureRecord features = ex.getFeatures();
 
-		aesthetic = mlc.predictSample(jsonA, 0);
+		aesthetic = mlc.predictSample(features, 0);
 
-		interest = mlc.predictSample(jsonI, 1);
+		interest = mlc.predictSample(features, 1);
 
-		json jsonSample = ex.getJsonAll();
+		features[FEAT_AESTHETIC] = aesthetic;
+		features[FEAT_INTEREST] = interest;
 
 		string finalName;
+		string tempName = fileNames.at(nv);
+		string destName = tempName.substr(tempName.find_last_of('/') + 1, tempName.size());
+		finalName = destName.substr(6, destName.find_last_of('.'));
+
 		if (myfile.is_open()) {
-			string tempName = fileNames.at(nv);
-			string destName = tempName.substr(tempName.find_last_of('/') + 1, tempName.size());
-			finalName = destName.substr(6, destName.find_last_of('.'));
-
-			myfile << nv + 1
-				<< "," << jsonSample["width"]
-				<< "," << jsonSample["height"]
-				<< "," << jsonSample["red_ratio"]
-				<< "," << jsonSample["red_moments1"]
-				<< "," << jsonSample["red_moments2"]
-				<< "," << jsonSample["green_ratio"]
-				<< "," << jsonSample["green_moments1"]
-				<< "," << jsonSample["green_moments2"]
-				<< "," << jsonSample["blue_ratio"]
-				<< "," << jsonSample["blue_moments1"]
-				<< "," << jsonSample["blue_moments2"];
-
-			myfile << "," << jsonSample["focus"]
-				<< "," << jsonSample["luminance"]
-				<< "," << jsonSample["luminance_std"]
-				<< "," << jsonSample["red_moments3"]
-				<< "," << jsonSample["red_moments4"]
-				<< "," << jsonSample["green_moments3"]
-				<< "," << jsonSample["green_moments4"]
-				<< "," << jsonSample["blue_moments3"]
-				<< "," << jsonSample["blue_moments4"];
-
-			myfile << "," << jsonSample["dif_hues"]
-				<< "," << jsonSample["faces"]
-				<< "," << jsonSample["faces_area"]
-				<< "," << jsonSample["smiles"]
-				<< "," << jsonSample["rule_of_thirds"]
-				<< "," << jsonSample["static_saliency"]
-				<< "," << jsonSample["rank_sum"]
-				<< "," << jsonSample["fps"]
-				<< "," << jsonSample["hues_std"]
-				<< "," << jsonSample["shackiness"]
-				<< "," << jsonSample["motion_mag"]
-				<< "," << jsonSample["fg_area"]
-				<< "," << jsonSample["shadow_area"]
-				<< "," << jsonSample["bg_area"]
-				<< "," << jsonSample["camera_move"]
-				<< "," << jsonSample["focus_diff"]
-				<< "," << aesthetic
-				<< "," << interest
-				<< "," << jsonSample["hues_skewness"]
-				<< "," << jsonSample["hues_kurtosis"];
-
-
-			myfile << "," << jsonSample["eh_0"]
-				<< "," << jsonSample["eh_1"]
-				<< "," << jsonSample["eh_2"]
-				<< "," << jsonSample["eh_3"]
-				<< "," << jsonSample["eh_4"]
-				<< "," << jsonSample["eh_5"]
-				<< "," << jsonSample["eh_6"]
-				<< "," << jsonSample["eh_7"]
-				<< "," << jsonSample["eh_8"]
-				<< "," << jsonSample["eh_9"]
-				<< "," << jsonSample["eh_10"]
-				<< "," << jsonSample["eh_11"]
-				<< "," << jsonSample["eh_12"]
-				<< "," << jsonSample["eh_13"]
-				<< "," << jsonSample["eh_14"]
-				<< "," << jsonSample["eh_15"]
-				<< "," << jsonSample["eh_16"]
-				<< "," << jsonSample["entropy"]
-				<< "," << jsonSample["edge_strenght"];
-
-			myfile << "," << jsonSample["luminance_skewness"]
-				<< "," << jsonSample["luminance_kurtosis"]
-				<< "," << jsonSample["entropy_std"]
-				<< "," << jsonSample["entropy_skewness"]
-				<< "," << jsonSample["entropy_kurtosis"]
-				<< "," << jsonSample["focus_std"]
-				<< "," << jsonSample["focus_skewness"]
-				<< "," << jsonSample["focus_kurtosis"]
-				<< "," << jsonSample["mag_std"]
-				<< "," << jsonSample["mag_skewness"]
-				<< "," << jsonSample["mag_kurtosis"]
-				<< "," << jsonSample["uflowx_mean"]
-				<< "," << jsonSample["uflowx_std"]
-				<< "," << jsonSample["uflowx_skewness"]
-				<< "," << jsonSample["uflowx_kurtosis"]
-				<< "," << jsonSample["uflowy_mean"]
-				<< "," << jsonSample["uflowy_std"]
-				<< "," << jsonSample["uflowy_skewness"]
-				<< "," << jsonSample["uflowy_kurtosis"];
-
-			myfile << "," << jsonSample["sflowx_mean"]
-				<< "," << jsonSample["sflowx_std"]
-				<< "," << jsonSample["sflowx_skewness"]
-				<< "," << jsonSample["sflowx_kurtosis"]
-				<< "," << jsonSample["sflowy_mean"]
-				<< "," << jsonSample["sflowy_std"]
-				<< "," << jsonSample["sflowy_skewness"]
-				<< "," << jsonSample["sflowy_kurtosis"]
-				<< "," << jsonSample["colorfullness_rg1"]
-				<< "," << jsonSample["colorfullness_rg2"]
-				<< "," << jsonSample["colorfullness_yb1"]
-				<< "," << jsonSample["colorfullness_yb2"]
-				<< "," << jsonSample["duration"]
-				<< "," << jsonSample["saturation_1"]
-				<< "," << jsonSample["saturation_2"]
-				<< "," << jsonSample["brightness_1"]
-				<< "," << jsonSample["brightness_2"]
-				<< "," << jsonSample["colorfull_1"]
-				<< "," << jsonSample["colorfull_2"];
-
-			myfile << "\n";
+			myfile << formatCsvRow(nv + 1, features) << "\n";
 			myfile.flush();
+		}
+
+		//Same sample into the feature store, and to the gallery
+		string fileName = fileNames.at(nv);
+		fileName = fileName.substr(fileName.find_last_of("/\\") + 1);
+		VideoFile storeVideo(fileName, VideoFile::filesFolderPath + "/" + fileName);
 
+		while (semanticTemp.size() < 5) {
+			semanticTemp.push_back(pair<double, int>(-1, -1));
 		}
+
+		if (!features.isFinite()) {
+			cout << " [!] " << storeVideo.name << " not added to feature store: invalid feature values" << endl;
+			if (queue != nullptr)
+				queue->skip();						//Shown from output.csv after the next start
+		}
+		else {
+			storeVideo.getMetadataFromFeatures(nv + 1, features);
+			storeVideo.getMetadataFromSemanticSample(semanticTemp);
+			storeVideo.getMetadataFromAudioSample(audioTemp);
+			storeVideo.writeToStore(storeWriter, storeWriter.addRow());
+			uncommittedRows++;
+			if (queue != nullptr)
+				queue->push(storeVideo);
+		}
+		if (uncommittedRows >= 10 && storeWriter.commit(featureStorePath)) {
+			uncommittedRows = 0;		//Keep already extracted files if extraction stops, appended after the first commit
+		}
+
 		auto end = chrono::high_resolution_clock::now();
 		cout << " [!] File " << finalName << " processed in : " <<
 			duration_cast<chrono::milliseconds>(end - start).count() << " ms\n" << endl;
@@ -867,7 +811,12 @@ bool Gallery::extractVideoData() {
 	}
 	mysemanticfile.close();
 	myfile.close();
-	return true;
+	if (!storeWriter.commit(featureStorePath)) {
+		cout << " [!] feature store not saved: " << featureStorePath << endl;
+		return false;
+	}
+	cout << " [*] feature store saved: " << featureStorePath << endl;
+	return !cancelled;
 }
 
 bool Gallery::loadFiles()
@@ -890,34 +839,90 @@ bool Gallery::loadFiles()
 		clNames.assign(1000, "");                       //1000 semantic concepts
 		clNames = readClassNames();
 
+		if (journal != nullptr)
+			journal->close();							//Journal compacts into the store, which is reopened below
+		File::journal = nullptr;
+		if (featureStore == nullptr)
+			featureStore = new FeatureStore();
+		if (featureStore->open(featureStorePath))
+			cout << " [*] feature store: " << featureStore->size() << " files" << endl;
+
+		vector<string> thumbnailPaths(vectorSize);		//Decoded when shown, see ThumbnailCache
+
+		ThreadPool pool;								//Csv and xml parsing
+		bool csvParsed = false;
+		int migrated = 0;								//Files not found in the store
+		vector<int> xmlFiles;							//Files to read from xml, parsed in parallel below
+
 		for (int k = 0; k < vectorSize; ++k)
 		{
 			VideoFile tmpVideo = VideoFile(vidDir.getName(k), vidDir.getPath(k));
+			int row = featureStore->isOpen() ? featureStore->rowOf(k + 1) : -1;
 
-			if (ofFile::doesFileExist(tmpVideo.xmlPath)) {			//If doesn't xmlDataExists
+			if (row >= 0 && featureStore->getString(row, COL_NAME) == tmpVideo.name &&
+				featureStore->getString(row, COL_EXTENSION) == tmpVideo.extension) {
 
-				tmpVideo.getMetadataFromXml();		//Get metada from the xml
+				tmpVideo.getMetadataFromStore(*featureStore, row);	//Get metadata from the store
 			}
-			else {
+			else if (ofFile::doesFileExist(tmpVideo.xmlPath)) {		//Older catalog, xml per file
 
-				vector<string> test = getIndividualSample(to_string(k + 1));
-				tmpVideo.getMetadataFromCsv(test);
+				xmlFiles.push_back(k);
+				migrated++;
+			}
+			else {
 
-				vector<pair<double, int> > semanticSample = semanticData[k];
-				tmpVideo.getMetadataFromSemanticSample(semanticSample);
+				if (!csvParsed) {
+					parseCsvFeatureVector(&pool);
+					parseSemanticVector(&pool);
+					parseAudioVector(&pool);
+					csvParsed = true;
+				}
 
-				vector <double > audioSample = audioData[k];
-				tmpVideo.getMetadataFromAudioSample(audioSample);
+				if (!tmpVideo.getMetadataFromCsv(csvData, csvData.rowOf(k + 1)))
+					cout << " [!] " << tmpVideo.name << " not found in " << dataOutputPath << endl;
 
-				tmpVideo.generateXmlFile();
-				tmpVideo.getMetadataFromXml();
+				tmpVideo.getMetadataFromSemanticSample(getSemanticSample(k));
+				tmpVideo.getMetadataFromAudioSample(getAudioSample(k));
+				migrated++;
 			}
 
 			allFiles[k] = tmpVideo;								//Create file with initialized data
 			allFiles[k].setType(File::fileType::VIDEO);
+			thumbnailPaths[k] = allFiles[k].thumbnailPath;
 			
 
 		}
+
+		if (xmlFiles.size() > 0) {
+			//Metadata only, thumbnails are decoded by the ThumbnailCache workers when shown
+			pool.parallelFor(xmlFiles.size(), [this, &xmlFiles](size_t i) {
+				allFiles[xmlFiles[i]].getMetadataFromXml();		//Get metada from the xml
+			});
+		}
+
+		int edits = replayJournal();					//Edits not yet folded into the store by the last session
+
+		if (migrated > 0 || edits > 0) {
+			if (migrated > 0)
+				cout << " [*] " << migrated << " files not in feature store, rewriting it" << endl;
+			if (saveFeatureStore())
+				MetadataJournal::truncate(journalPath);		//Edits are in the store now
+		}
+		if (thumbnails == nullptr)
+			thumbnails = new ThumbnailCache(File::thumbnailWidth, File::thumbnailHeight, thumbnailCacheSize);
+		thumbnails->setFiles(vector<string>());			//Nothing reads the archive while it is replaced
+		vector<int> thumbnailTiles;
+		if (!loadThumbnailArchive(thumbnailPaths, thumbnailTiles))
+			cout << " [!] thumbnail archive not available, thumbnails are decoded from " << thumbnailFolderPath << endl;
+		thumbnails->setFiles(thumbnailPaths, thumbnailArchive, thumbnailTiles);
+
+		if (journal == nullptr)
+			journal = new MetadataJournal();
+		if (journal->open(journalPath, featureStore->isOpen() ? featureStore : nullptr))
+			File::journal = journal;
+		csvData.clear();
+		semanticData.clear();
+		audioData.clear();
 		//cout << "Feature vector loaded!" << endl;
 		return true;
 
@@ -926,6 +931,151 @@ bool Gallery::loadFiles()
 
 }
 
+//Thumbnails are read from one mapped archive of decoded tiles. Files not in it
+//(new files, or no archive yet) are decoded from their jpg by the cache and
+//appended to the archive in the background, for the next start. Jpgs that
+//can't be read are listed in the archive, so they are not tried again
+bool Gallery::loadThumbnailArchive(const vector<string> &thumbnailPaths, vector<int> &tiles)
+{
+	if (thumbnailArchive == nullptr)
+		thumbnailArchive = new ThumbnailArchive();
+	if (thumbnailAppender == nullptr)
+		thumbnailAppender = new ThumbnailArchiveAppender();
+	thumbnailAppender->stop();							//Last append committed before the archive is opened again
+	tiles.assign(allFiles.size(), -1);
+
+	int width = File::thumbnailWidth;
+	int height = File::thumbnailHeight;
+	bool opened = thumbnailArchive->open(thumbnailArchivePath);
+	if (opened && (thumbnailArchive->tileWidth() != width || thumbnailArchive->tileHeight() != height)) {
+		cout << " [!] thumbnail archive has " << thumbnailArchive->tileWidth() << "x" << thumbnailArchive->tileHeight() << " thumbnails, writing it again" << endl;
+		thumbnailArchive->close();						//Mapped file can't be replaced on Windows
+		opened = false;
+	}
+
+	vector<string> missingNames;
+	vector<string> missingPaths;
+	for (size_t k = 0; k < allFiles.size(); ++k) {
+		if (opened) {
+			tiles[k] = thumbnailArchive->find(allFiles[k].name);
+			if (thumbnailArchive->contains(allFiles[k].name))
+				continue;								//Tile, or a jpg that failed before
+		}
+		missingNames.push_back(allFiles[k].name);
+		missingPaths.push_back(thumbnailPaths[k]);
+	}
+	if (opened)
+		cout << " [*] thumbnail archive: " << thumbnailArchive->size() << " thumbnails" << endl;
+	if (!missingNames.empty()) {
+		cout << " [*] " << missingNames.size() << " thumbnails not in archive, adding them in the background" << endl;
+		thumbnailAppender->start(thumbnailArchivePath, width, height, !opened, missingNames, missingPaths,
+			[width, height](const string &path, vector<unsigned char> &rgb, int &w, int &h) {
+			ofPixels pixels;
+			if (!ThumbnailCache::decode(path, width, height, pixels))
+				return false;
+			w = (int)pixels.getWidth();
+			h = (int)pixels.getHeight();
+			rgb.assign(pixels.getData(), pixels.getData() + (size_t)w * h * 3);
+			return true;
+		});
+	}
+	return opened;
+}
+
+int Gallery::replayJournal()
+{
+	vector<JournalEntry> edits;
+	if (!MetadataJournal::read(journalPath, edits))
+		cout << " [!] journal not readable: " << journalPath << endl;
+	if (edits.size() > 0) {
+		unordered_map<int, size_t> fileIndex;
+		for (size_t i = 0; i < allFiles.size(); ++i) {
+			fileIndex[allFiles[i].fileID] = i;
+		}
+		for (const JournalEntry &e : edits) {
+			unordered_map<int, size_t>::iterator it = fileIndex.find(e.fileID);
+			if (it != fileIndex.end())
+				allFiles[it->second].applyJournalEntry(e);
+		}
+		cout << " [*] " << edits.size() << " edits replayed from journal" << endl;
+	}
+	return (int)edits.size();
+}
+
+//What loadFiles would set up, for no files yet. The extraction thread only uses
+//ex, mlc and the output files; the gallery takes its clips in update
+void Gallery::startExtraction()
+{
+	clNames = readClassNames();
+	if (featureStore == nullptr)
+		featureStore = new FeatureStore();
+	if (thumbnails == nullptr)
+		thumbnails = new ThumbnailCache(File::thumbnailWidth, File::thumbnailHeight, thumbnailCacheSize);
+	thumbnails->setFiles(vector<string>());			//Thumbnails decoded from the jpgs until the next start
+	if (journal == nullptr)
+		journal = new MetadataJournal();
+	if (journal->open(journalPath, nullptr))		//Journal only, the store is being written
+		File::journal = journal;
+
+	ExtractionQueue *queue = new ExtractionQueue();
+	extraction = queue;
+	queue->start([this, queue] { return extractVideoData(queue); });
+}
+
+void Gallery::addExtractedFiles()
+{
+	bool finished = !extraction->isRunning();		//Before the take, so no clip is left behind
+	vector<VideoFile> clips;
+	if (extraction->take(clips) > 0) {
+		vector<string> thumbnailPaths;
+		for (VideoFile &clip : clips) {
+			clip.setType(File::fileType::VIDEO);
+			thumbnailPaths.push_back(clip.thumbnailPath);
+			allFiles.push_back(clip);
+		}
+		thumbnails->addFiles(thumbnailPaths);
+		filtersPanel.refilter(&allFiles[0], allFiles.size());	//New files go through the filters set meanwhile
+	}
+	if (!finished)
+		return;
+
+	//Store written by the extraction, rewritten with the edits made meanwhile
+	cout << " [*] Extraction done: " << allFiles.size() << " files" << endl;
+	File::journal = nullptr;
+	journal->close();
+	if (replayJournal() > 0 && !allFiles.empty()) {
+		filtersPanel.setFiles(&allFiles[0], allFiles.size());	//Rows again with the replayed rates
+		filtersPanel.refilter(&allFiles[0], allFiles.size());
+	}
+	if (!allFiles.empty() && saveFeatureStore())
+		MetadataJournal::truncate(journalPath);
+	else if (!featureStore->open(featureStorePath))
+		cout << " [!] feature store not opened: " << featureStorePath << endl;
+	if (journal->open(journalPath, featureStore->isOpen() ? featureStore : nullptr))
+		File::journal = journal;
+	if (!extraction->succeeded())
+		cout << " [!] extraction failed, files are extracted again on the next start" << endl;
+	else
+		lock();
+	delete extraction;
+	extraction = nullptr;
+}
+
+bool Gallery::saveFeatureStore()
+{
+	FeatureStoreWriter writer;
+	for (size_t i = 0; i < allFiles.size(); ++i) {
+		allFiles[i].writeToStore(writer, writer.addRow());
+	}
+
+	featureStore->close();								//Mapped file can't be replaced on Windows
+	if (!writer.commit(featureStorePath) || !featureStore->open(featureStorePath)) {
+		cout << "[error: Gallery.cpp] saveFeatureStore() " << featureStorePath << endl;
+		return false;
+	}
+	return true;
+}
+
 //Check if thumbnail was clicked. Sets thumbnailClicked flag and clicked thumbnail position
 bool Gallery::checkIfThumbnailClicked(int x, int y)
 {
@@ -935,16 +1085,11 @@ bool Gallery::checkIfThumbnailClicked(int x, int y)
 	}
 
 	thumbnailClicked = false;					//Assume that we didn't clicked thumbnail
-	for (int i = 0; i < allFiles.size(); ++i) {	//For all visible files
-		if (allFiles[i].getVisible()) {
-			ofPoint mousePoint;
-			mousePoint.set(x - margin, y - margin);		//Coordinates of mouse inside panel area
-			if (rectangles[i].inside(mousePoint)) {		//If mouse is over some image
-				choosenFileIndex = i;				//Save index
-				thumbnailClicked = true;
-				return thumbnailClicked;				//Return true
-			}
-		}
+	int k = layout.itemAt(x - margin, y - margin + contentScrollY);		//Coordinates of mouse inside panel content
+	if (k >= 0 && y - margin <= panelHeight) {	//If mouse is over some image
+		choosenFileIndex = layout.item(k);		//Save index
+		thumbnailClicked = true;
+		return thumbnailClicked;				//Return true
 	}
 	choosenFileIndex = -1;							//No thumbnail clicked (nor toolbar nor grip)
 	return thumbnailClicked;							//If thumbnail not clicked
@@ -960,6 +1105,23 @@ bool Gallery::checkIfVideoPreviewClicked(int x, int y)
 	else return false;
 }
 
+//Neighbours are opened too, the next click on one of them shows its first frame at once
+void Gallery::selectPreview(int fileIndex)
+{
+	vector<pair<int, string> > files;
+	files.push_back(make_pair(fileIndex, allFiles[fileIndex].path));
+	int k = layout.find(fileIndex);
+	if (k >= 0) {
+		int columns = layout.columns();
+		int neighbours[4] = { k + 1, k - 1, k + columns, k - columns };
+		for (int n : neighbours) {
+			if (n >= 0 && n < (int)layout.size() && (n / columns == k / columns || n % columns == k % columns))
+				files.push_back(make_pair(layout.item(n), allFiles[layout.item(n)].path));
+		}
+	}
+	previews->select(files);
+}
+
 bool Gallery::toolBarClicked(int x, int y)
 {
 	return filtersPanel.isToolbarClicked(x, y);
@@ -989,164 +1151,60 @@ ofRectangle Gallery::spaceForFileDisplay()
 	return space;
 }
 
-bool Gallery::parseSemanticVector() {
-
-	semanticData.assign(totalFiles, vector<pair<double, int>>(5));
-	ifstream myReadFile;
-	myReadFile.open(semanticDataOutputPath.c_str());
+bool Gallery::parseSemanticVector(ThreadPool *pool) {
 
-	string line;
-	if (myReadFile.fail())
+	if (!semanticData.load(semanticDataOutputPath, pool))
 	{
 		cout << "fail loading semantic vector!" << endl;
-		myReadFile.close();
 		return false;
 	}
-	else {
-
-		vector<pair<double, int>> tempVector;
-		tempVector.assign(5, pair<double, int>(0.0, 0));
-		int l = 0;
-		while (getline(myReadFile, line)) {
-
-			stringstream temp(line);
-			string word;
-			int w = 0;
-			int par = 0;
-
-			while (getline(temp, word, ',')) {
-
-				if (w % 2 == 0 || w == 0) {
-
-					tempVector.at(par).second = std::stoi(word);
-				}
-				else {
-					tempVector.at(par).first = std::stod(word);
-					par++;
-
-				}
-				w++;
-			}
-			int dif = 5 - w / 2;
-			while (dif > 0) {
-				tempVector.at(5 - dif).first = -1;
-				tempVector.at(5 - dif).second = -1;
-
-				dif--;
-			}
-			semanticData.at(l) = tempVector;
-			l++;
-		}
-
-	}
-	myReadFile.close();
 	return true;
 }
 
+vector<pair<double, int> > Gallery::getSemanticSample(int line) {
 
-bool Gallery::parseAudioVector() {
+	//Line is classId,prob pairs. Missing pairs are -1 like in the csv parse before
+	vector<pair<double, int> > sample(5, pair<double, int>(-1, -1));
+	size_t pairs = semanticData.cells(line) / 2;
+	for (size_t p = 0; p < pairs && p < 5; ++p) {
+		sample[p].second = semanticData.getInt(line, p * 2);
+		sample[p].first = semanticData.get(line, p * 2 + 1);
+	}
+	return sample;
+}
 
-	audioData.assign(totalFiles, vector<double>(25));
-	ifstream myReadFile;
-	myReadFile.open(audioDataOutputPath.c_str());
+bool Gallery::parseAudioVector(ThreadPool *pool) {
 
-	string line;
-	if (myReadFile.fail())
+	if (!audioData.load(audioDataOutputPath, pool))
 	{
 		cout << "fail loading audio vector!" << endl;
-		myReadFile.close();
 		return false;
 	}
-	else {
-
-		vector<double> tempVector;
-		tempVector.assign(25, 0.0);
-		int l = 0;
-		while (getline(myReadFile, line)) {
-
-			stringstream temp(line);
-			string word;
-			int w = 0;
-
-			while (getline(temp, word, ',')) {
-
-				tempVector.at(w) = std::stod(word);
-
-				w++;
-			}
-
-			audioData.at(l) = tempVector;
-			l++;
-		}
-
-	}
-	myReadFile.close();
 	return true;
 }
 
-int Gallery::parseCsvFeatureVector() {
-
-	ifstream myReadFile;
-	myReadFile.open(dataOutputPath.c_str());
+vector<double> Gallery::getAudioSample(int line) {
 
-	string line;
-	int l = 0;
-	int w = 0;
-
-	if (myReadFile.fail())
-	{
-		cout << "fail loading csv feature vector!" << endl;
-		myReadFile.close();
-		return 0;
-	}
-	else {
-		csvData.assign(totalFiles, vector<string>(150, ""));
-
-		while (getline(myReadFile, line)) {
-
-			stringstream temp(line);
-			string word;
-			vector <string> linevec;
-			linevec.assign(150, "");
-
-			while (getline(temp, word, ',')) {
-
-				linevec[w] = word;
-				w++;
-			}
-
-			w = 0;
-			csvData[l] = linevec;
-			l++;
+	vector<double> sample;
+	if (audioData.cells(line) > 0) {
+		sample.assign(25, 0.0);
+		for (size_t c = 0; c < audioData.cells(line) && c < 25; ++c) {
+			sample[c] = audioData.get(line, c);
 		}
-
 	}
-	myReadFile.close();
-	return l;
+	return sample;
 }
 
-vector<string> Gallery::getIndividualSample(string name) {
-
-	vector<string> vecStr;
+int Gallery::parseCsvFeatureVector(ThreadPool *pool) {
 
-	if (csvData.size() > 0)
+	if (!csvData.load(dataOutputPath, pool))
 	{
-		int i = 0;
-		while (i < csvData.size())
-		{
-			if (csvData[i][0] == name)
-			{
-				vecStr = csvData[i];
-				break;
-			}
-			i++;
-		}
-	}
-	else {
-		vecStr.assign(1, "");
+		cout << "fail loading csv feature vector!" << endl;
+		return 0;
 	}
-
-	return vecStr;
+	if (csvData.badCells() > 0)
+		cout << " [!] " << csvData.badCells() << " non numeric cells in " << dataOutputPath << endl;
+	return (int)csvData.rows();
 }
 
 std::vector<String> Gallery::readClassNames()
@@ -1157,7 +1215,7 @@ std::vector<String> Gallery::readClassNames()
 	if (!fp.is_open())
 	{
 		std::cerr << "File with classes labels not found: " << filename << std::endl;
-		exit(-1);
+		::exit(-1);
 	}
 	std::string name;
 	while (!fp.eof())
@@ -1173,11 +1231,11 @@ std::vector<String> Gallery::readClassNames()
 
 void Gallery::getConfigParams() {
 
-	ofXml* xml = new ofXml(ex.configPath);
-	if (xml->load(ex.configPath)) {
-		parseOnly = xml->getValue<bool>("//PARSE_ONLY");
-		inputFolder = xml->getValue<string>("//INPUT_FOLDER");
-		totalFiles = xml->getValue<int>("//TOTAL_FILES");
+	XmlFieldReader xml;						//Same reader as the extractor, paths relative to bin
+	if (xml.load(ex.configPath)) {
+		parseOnly = xml.getInt("PARSE_ONLY") != 0;
+		inputFolder = xml.getString("INPUT_FOLDER");
+		totalFiles = xml.getInt("TOTAL_FILES");
 	}
 }
 string Gallery::thumbnailFolderPath = "data/thumbnails/videos/";
\ No newline at end of file
@@ -6,9 +6,14 @@
 #include "ImageFile.h"
 #include "metadataPanel.h"
 #include "filtersPanel.h"
+#include "GalleryLayout.h"
+#include "ThumbnailCache.h"
+#include "PreviewPool.h"
+#include "ExtractionQueue.h"
 #include "cctype"
 #include "extractor.h"
 #include "mlclass.h"
+#include "ThreadPool.h"
 
 #include <iostream>
 #include <chrono>
@@ -22,6 +27,7 @@ public:
 	void setup();
 	void update();
 	void draw();
+	void exit();
 
 	void keyPressed(int key);
 	void keyReleased(int key);
@@ -39,7 +45,7 @@ public:
 	void lock();
 	void unLock();
 	bool extractVideoThumbnails();
-	bool extractVideoData();
+	bool extractVideoData(ExtractionQueue *queue = nullptr);	//Finished clips pushed to queue
 	bool parseOnly = false;
 
 	//bool savePreSortProcessing(int size);
@@ -64,21 +70,31 @@ private:
 	string audioDataOutputPath = "data/audio/audio_result.csv";
 	string semanticDataOutputPath = "data/output/semantic_data.csv"; //output from extraction process
 	string dataOutputPath = "data/output/output.csv"; //output from extraction process
+	string featureStorePath = "data/output/features.vqa"; //binary feature store, main load source
+	string journalPath = "data/output/features.vqa.wal"; //rate/similarity edits not yet in feature store
+	string thumbnailArchivePath = "data/thumbnails/videos.vqt"; //decoded thumbnails, built from the jpgs
 	string cheaterDataOutputPath = "data/output/cheatersort.csv"; //pre processing sort
 	string inputFolder = "data/files/";               //video input files
 	string xmlFolderPath = "/xml/";                   //Path to folder with metadata
 
 	void getConfigParams();
 	bool loadFiles();								//Load data to allFiles vector 	
+	bool saveFeatureStore();						//Rewrite feature store from allFiles
+	int replayJournal();							//Edits not yet in the store, applied to allFiles
+	void startExtraction();							//Gallery starts empty, clips are added as they are extracted
+	void addExtractedFiles();						//Clips extracted since the last frame, once per update
+	bool loadThumbnailArchive(const vector<string> &thumbnailPaths, vector<int> &tiles);	//Tile per file, missing ones appended in the background
 	bool checkIfThumbnailClicked(int x, int y);		//Saves index to choosenFileIndex. Sets thumbnailClicked flag
 	bool checkIfVideoPreviewClicked(int x, int y);	
+	void selectPreview(int fileIndex);				//Show the file, open its grid neighbours
 	bool toolBarClicked(int x, int y);				//Check if "click" was over toolbar
 	ofRectangle spaceForFileDisplay();
 
-	bool parseSemanticVector();
-	bool parseAudioVector();
-	int parseCsvFeatureVector();					//Load data to allFiles vector 
-	vector<string> getIndividualSample(string name);
+	bool parseSemanticVector(ThreadPool *pool);
+	bool parseAudioVector(ThreadPool *pool);
+	int parseCsvFeatureVector(ThreadPool *pool);	//Load data to allFiles vector 
+	vector< pair <double, int > > getSemanticSample(int line);	//(prob, classId) x5, -1 padded
+	vector< double > getAudioSample(int line);					//Empty if line missing
 
 	std::vector<String> readClassNames();
 
@@ -91,10 +107,18 @@ private:
 	filtersPanel filtersPanel;				//Object to filter displayed data
 	ofRectangle fileSpace;					//Space avaiable for displaying image/video
 	bool videoPlay;							//Flag if video should play
-	vector <vector <string> >csvData;
+	CsvTable csvData;						//output.csv, rows looked up by file ID
 	int numberOfselectedFiles;
-	vector <vector< pair <double, int > > > semanticData;
-	vector <vector< double > > audioData;
+	CsvTable semanticData;					//semantic_data.csv, one line per file
+	CsvTable audioData;						//audio_result.csv, one line per file
+	FeatureStore *featureStore = nullptr;	//Mapped metadata of all files
+	MetadataJournal *journal = nullptr;		//Background writer of user edits
+	ThumbnailArchive *thumbnailArchive = nullptr;	//Mapped tiles of all thumbnails
+	ThumbnailArchiveAppender *thumbnailAppender = nullptr;	//Adds the thumbnails the archive is missing
+	ThumbnailCache *thumbnails = nullptr;	//Decoded thumbnails of the files in and near the view
+	PreviewPool *previews = nullptr;		//Players of the choosen video and its neighbours
+	size_t thumbnailCacheSize = 572;		//Thumbnails kept on the GPU, 4 atlas pages
+	ExtractionQueue *extraction = nullptr;	//Background extraction, until it is done
 
 	/*Thumbnails parameteres*/
 	int thumbnailsWidth;
@@ -132,7 +156,8 @@ private:
 	bool isDraggingGrip;
 	bool isMouseOverGrip;
 	int mousePreviousY;
-	vector<ofRectangle> rectangles;
+	GalleryLayout layout;					//Thumbnail positions
+	unsigned layoutVersion;					//filtersPanel.displayVersion() of the layout
 
 	struct sort_pred {
 		bool operator()(const std::pair<int, double> &left, const std::pair<int, double> &right) {
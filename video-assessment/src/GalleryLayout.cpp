@@ -0,0 +1,86 @@
+#include "GalleryLayout.h"
+
+#include <algorithm>
+
+using namespace std;
+
+GalleryLayout::GalleryLayout() : cellWidth(1), cellHeight(1), gap(0), columnCount(1)
+{
+}
+
+void GalleryLayout::setCell(int width, int height, int gap)
+{
+	cellWidth = max(1, width);
+	cellHeight = max(1, height);
+	this->gap = max(0, gap);
+}
+
+//Same rule as placing one by one: next item goes on a new row if it would pass availableWidth
+void GalleryLayout::setWidth(int availableWidth)
+{
+	columnCount = availableWidth < cellWidth ? 1 : (availableWidth - cellWidth) / (cellWidth + gap) + 1;
+}
+
+void GalleryLayout::setItems(const vector<int> &items)
+{
+	this->items = items;
+}
+
+size_t GalleryLayout::size() const
+{
+	return items.size();
+}
+
+int GalleryLayout::item(size_t k) const
+{
+	return items[k];
+}
+
+int GalleryLayout::columns() const
+{
+	return columnCount;
+}
+
+int GalleryLayout::x(size_t k) const
+{
+	return (int)(k % columnCount) * (cellWidth + gap);
+}
+
+int GalleryLayout::y(size_t k) const
+{
+	return (int)(k / columnCount) * (cellHeight + gap);
+}
+
+int GalleryLayout::contentHeight() const
+{
+	return items.empty() ? 0 : y(items.size() - 1) + cellHeight;
+}
+
+void GalleryLayout::itemsInView(int scrollY, int viewHeight, size_t &first, size_t &last) const
+{
+	int pitch = cellHeight + gap;
+	int firstRow = max(0, (scrollY - cellHeight) / pitch);			//Rows ending above the view are skipped
+	int lastRow = max(0, (scrollY + viewHeight) / pitch + 1);		//Exclusive
+	first = min(items.size(), (size_t)firstRow * columnCount);
+	last = min(items.size(), (size_t)lastRow * columnCount);
+}
+
+int GalleryLayout::itemAt(int x, int y) const
+{
+	if (x < 0 || y < 0) {
+		return -1;
+	}
+	int column = x / (cellWidth + gap);
+	int row = y / (cellHeight + gap);
+	if (column >= columnCount || x - column * (cellWidth + gap) > cellWidth || y - row * (cellHeight + gap) > cellHeight) {
+		return -1;								//In a gap
+	}
+	size_t k = (size_t)row * columnCount + column;
+	return k < items.size() ? (int)k : -1;
+}
+
+int GalleryLayout::find(int item) const
+{
+	vector<int>::const_iterator it = std::find(items.begin(), items.end(), item);
+	return it == items.end() ? -1 : (int)(it - items.begin());
+}
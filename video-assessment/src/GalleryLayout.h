@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//Grid placement of the gallery thumbnails. Items are file indexes in display
+//order; item k sits at column k % columns, row k / columns, so positions, the
+//items in view and the item under the mouse are computed, never stored. Only a
+//change of the items needs a pass over them.
+class GalleryLayout
+{
+public:
+	GalleryLayout();
+
+	void setCell(int width, int height, int gap);
+	void setWidth(int availableWidth);			//Columns that fit, at least 1
+	void setItems(const std::vector<int> &items);
+
+	size_t size() const;
+	int item(size_t k) const;
+	int columns() const;
+	int x(size_t k) const;						//Top left, in content coordinates
+	int y(size_t k) const;
+	int contentHeight() const;					//Bottom of the last item, 0 if none
+
+	void itemsInView(int scrollY, int viewHeight, size_t &first, size_t &last) const;	//Items [first, last) reach the view
+	int itemAt(int x, int y) const;				//Item under a content point, -1 if none
+	int find(int item) const;					//Position k of an item, -1 if not laid out
+
+private:
+	int cellWidth;
+	int cellHeight;
+	int gap;
+	int columnCount;
+	std::vector<int> items;
+};
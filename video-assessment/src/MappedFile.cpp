@@ -0,0 +1,109 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	mapped = nullptr;
+	length = 0;
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = nullptr;
+#else
+	fd = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string &path)
+{
+	close();
+#ifdef _WIN32
+	//FILE_SHARE_WRITE so in-place patches can still be written while mapped
+	fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		close();
+		return false;
+	}
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == nullptr) {
+		close();
+		return false;
+	}
+	mapped = (const char *)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (mapped == nullptr) {
+		close();
+		return false;
+	}
+	length = (size_t)fileSize.QuadPart;
+#else
+	fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close();
+		return false;
+	}
+	void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (p == MAP_FAILED) {
+		close();
+		return false;
+	}
+	mapped = (const char *)p;
+	length = (size_t)st.st_size;
+#endif
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (mapped != nullptr) UnmapViewOfFile(mapped);
+	if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+	mappingHandle = nullptr;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (mapped != nullptr) munmap((void *)mapped, length);
+	if (fd >= 0) ::close(fd);
+	fd = -1;
+#endif
+	mapped = nullptr;
+	length = 0;
+}
+
+bool MappedFile::isOpen() const
+{
+	return mapped != nullptr;
+}
+
+const char *MappedFile::data() const
+{
+	return mapped;
+}
+
+size_t MappedFile::size() const
+{
+	return length;
+}
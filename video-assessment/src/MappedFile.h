@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+//Read-only memory mapping of a whole file. Used for the binary stores so
+//loading doesn't go through ifstream/getline.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const std::string &path);		//Map file, false if missing or empty
+	void close();
+	bool isOpen() const;
+
+	const char *data() const;
+	size_t size() const;
+
+private:
+	MappedFile(const MappedFile &);				//Not copyable, owns the mapping
+	MappedFile &operator=(const MappedFile &);
+
+	const char *mapped;
+	size_t length;
+#ifdef _WIN32
+	void *fileHandle;
+	void *mappingHandle;
+#else
+	int fd;
+#endif
+};
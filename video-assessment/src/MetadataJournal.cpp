@@ -0,0 +1,330 @@
+#include "MetadataJournal.h"
+
+#include <cstring>
+#include <iostream>
+#include <map>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+	const size_t recordHeader = 16;
+
+	uint32_t checksum(const char *data, size_t length)
+	{
+		uint32_t h = 2166136261u;			//FNV-1a
+		for (size_t i = 0; i < length; ++i) {
+			h ^= (unsigned char)data[i];
+			h *= 16777619u;
+		}
+		return h;
+	}
+
+	void syncFile(FILE *f)
+	{
+		fflush(f);
+#ifdef _WIN32
+		_commit(_fileno(f));
+#else
+		fsync(fileno(f));
+#endif
+	}
+
+	//Record without length and checksum, those are computed over this part
+	void encode(const JournalEntry &e, string &out)
+	{
+		int32_t id = e.fileID;
+		uint16_t column = (uint16_t)e.column;
+		uint16_t type = (uint16_t)featureColumns[e.column].type;
+		out.append((const char *)&id, 4);
+		out.append((const char *)&column, 2);
+		out.append((const char *)&type, 2);
+		if (type == FEATURE_INT) out.append((const char *)&e.intValue, 4);
+		else if (type == FEATURE_FLOAT) out.append((const char *)&e.floatValue, 4);
+		else out.append(e.stringValue);
+	}
+
+	//Length and checksum framed records of all entries
+	string encodeRecords(const vector<JournalEntry> &entries)
+	{
+		string buffer;
+		string record;
+		for (size_t i = 0; i < entries.size(); ++i) {
+			record.clear();
+			encode(entries[i], record);
+			uint32_t length = (uint32_t)(record.size() + 8);
+			uint32_t sum = checksum(record.data(), record.size());
+			buffer.append((const char *)&length, 4);
+			buffer.append((const char *)&sum, 4);
+			buffer.append(record);
+		}
+		return buffer;
+	}
+
+	bool replaceFile(const string &from, const string &to)
+	{
+#ifdef _WIN32
+		return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		return rename(from.c_str(), to.c_str()) == 0;
+#endif
+	}
+}
+
+MetadataJournal::MetadataJournal()
+{
+	featureStore = nullptr;
+	file = nullptr;
+	writing = 0;
+	stopping = false;
+}
+
+MetadataJournal::~MetadataJournal()
+{
+	close();
+}
+
+bool MetadataJournal::open(const string &path, FeatureStore *store)
+{
+	close();
+	file = fopen(path.c_str(), "ab");
+	if (file == nullptr) {
+		cout << "[error: MetadataJournal.cpp] cannot open " << path << endl;
+		return false;
+	}
+	journalPath = path;
+	featureStore = store;
+	stopping = false;
+	thread = std::thread(&MetadataJournal::writer, this);
+	return true;
+}
+
+void MetadataJournal::close()
+{
+	if (thread.joinable()) {
+		{
+			lock_guard<mutex> lock(queueMutex);
+			stopping = true;
+		}
+		queued.notify_one();
+		thread.join();
+	}
+	if (file != nullptr) {
+		fclose(file);
+		file = nullptr;
+	}
+	uncompacted.clear();		//Final compact done or skipped (no store), the file still has them for the next replay
+}
+
+void MetadataJournal::setInt(int fileID, FeatureColumn column, int value)
+{
+	JournalEntry e;
+	e.fileID = fileID;
+	e.column = column;
+	e.intValue = value;
+	e.floatValue = 0;
+	push(e);
+}
+
+void MetadataJournal::push(const JournalEntry &entry)
+{
+	{
+		lock_guard<mutex> lock(queueMutex);
+		queue.push_back(entry);
+	}
+	queued.notify_one();
+}
+
+void MetadataJournal::flush()
+{
+	if (!thread.joinable()) {
+		return;
+	}
+	unique_lock<mutex> lock(queueMutex);
+	written.wait(lock, [this] { return queue.empty() && writing == 0; });
+}
+
+void MetadataJournal::writer()
+{
+	vector<JournalEntry> batch;
+	for (;;) {
+		{
+			unique_lock<mutex> lock(queueMutex);
+			queued.wait(lock, [this] { return stopping || !queue.empty(); });
+			if (queue.empty() && stopping) {
+				break;
+			}
+			batch.swap(queue);			//Everything queued so far goes in one write
+			writing = batch.size();
+		}
+
+		if (!append(batch)) {
+			cout << "[error: MetadataJournal.cpp] " << batch.size() << " edits not saved to " << journalPath << endl;
+		}
+		uncompacted.insert(uncompacted.end(), batch.begin(), batch.end());
+		batch.clear();
+		if (uncompacted.size() >= COMPACT_EVERY) {
+			compact();
+		}
+
+		{
+			lock_guard<mutex> lock(queueMutex);
+			writing = 0;
+		}
+		written.notify_all();
+	}
+	if (!uncompacted.empty()) {
+		compact();
+	}
+	written.notify_all();
+}
+
+bool MetadataJournal::append(const vector<JournalEntry> &batch)
+{
+	if (file == nullptr) {
+		return false;
+	}
+	string buffer = encodeRecords(batch);
+	bool ok = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+	syncFile(file);
+	return ok;
+}
+
+//Fold journal into the store: the last edit of each cell is patched, the store
+//is synced, then the journal is replaced by the edits that could not be patched
+//(file not in the store, string not in its dictionary). Those are retried at
+//every compaction, and replayed into a rewritten store by the gallery at startup.
+void MetadataJournal::compact()
+{
+	if (featureStore == nullptr || !featureStore->isOpen()) {
+		return;
+	}
+	map<pair<int, int>, size_t> last;			//Earlier edits of a cell are overwritten anyway
+	for (size_t i = 0; i < uncompacted.size(); ++i) {
+		last[make_pair(uncompacted[i].fileID, (int)uncompacted[i].column)] = i;
+	}
+	vector<JournalEntry> unpatched;
+	for (size_t i = 0; i < uncompacted.size(); ++i) {
+		const JournalEntry &e = uncompacted[i];
+		if (last[make_pair(e.fileID, (int)e.column)] != i) {
+			continue;
+		}
+		int row = featureStore->rowOf(e.fileID);
+		bool ok = false;
+		if (row >= 0) {
+			FeatureColumnType type = featureColumns[e.column].type;
+			if (type == FEATURE_INT) ok = featureStore->patchInt(row, e.column, e.intValue);
+			else if (type == FEATURE_FLOAT) ok = featureStore->patchFloat(row, e.column, e.floatValue);
+			else ok = featureStore->patchString(row, e.column, e.stringValue);
+		}
+		if (!ok) {
+			unpatched.push_back(e);
+		}
+	}
+	//Patches must be on disk before the journal entries holding them are dropped
+	if (!featureStore->sync()) {
+		cout << "[error: MetadataJournal.cpp] feature store not synced, journal kept" << endl;
+		return;
+	}
+	if (!rewrite(unpatched)) {
+		cout << "[error: MetadataJournal.cpp] cannot rewrite " << journalPath << ", journal kept" << endl;
+		return;
+	}
+	uncompacted.swap(unpatched);
+}
+
+//Replace the journal file with the given entries, written and synced to a
+//temporary file first so a crash leaves either journal whole
+bool MetadataJournal::rewrite(const vector<JournalEntry> &entries)
+{
+	string tmpPath = journalPath + ".tmp";
+	FILE *tmp = fopen(tmpPath.c_str(), "wb");
+	if (tmp == nullptr) {
+		return false;
+	}
+	string buffer = encodeRecords(entries);
+	bool ok = fwrite(buffer.data(), 1, buffer.size(), tmp) == buffer.size();
+	syncFile(tmp);
+	fclose(tmp);
+	if (ok) {
+		if (file != nullptr) {
+			fclose(file);						//Can't rename over an open file on Windows
+		}
+		ok = replaceFile(tmpPath, journalPath);
+		file = fopen(journalPath.c_str(), "ab");
+		ok = ok && file != nullptr;
+	}
+	if (!ok) {
+		remove(tmpPath.c_str());
+	}
+	return ok;
+}
+
+bool MetadataJournal::read(const string &path, vector<JournalEntry> &entries)
+{
+	entries.clear();
+	FILE *f = fopen(path.c_str(), "rb");
+	if (f == nullptr) {
+		return true;					//No journal, nothing to replay
+	}
+	string data;
+	char chunk[65536];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+		data.append(chunk, n);
+	}
+	bool ok = ferror(f) == 0;
+	fclose(f);
+
+	size_t p = 0;
+	while (p + recordHeader <= data.size()) {
+		uint32_t length, sum;
+		memcpy(&length, &data[p], 4);
+		memcpy(&sum, &data[p + 4], 4);
+		if (length < recordHeader || p + length > data.size() || checksum(&data[p + 8], length - 8) != sum) {
+			break;						//Torn tail after a crash
+		}
+		JournalEntry e;
+		int32_t id;
+		uint16_t column, type;
+		memcpy(&id, &data[p + 8], 4);
+		memcpy(&column, &data[p + 12], 2);
+		memcpy(&type, &data[p + 14], 2);
+		if (column >= COL_COUNT || type != featureColumns[column].type) {
+			break;
+		}
+		e.fileID = id;
+		e.column = (FeatureColumn)column;
+		e.intValue = 0;
+		e.floatValue = 0;
+		const char *value = &data[p + recordHeader];
+		size_t valueLength = length - recordHeader;
+		if (type == FEATURE_INT && valueLength == 4) memcpy(&e.intValue, value, 4);
+		else if (type == FEATURE_FLOAT && valueLength == 4) memcpy(&e.floatValue, value, 4);
+		else if (type == FEATURE_STRING) e.stringValue.assign(value, valueLength);
+		else break;
+		entries.push_back(e);
+		p += length;
+	}
+	return ok;
+}
+
+bool MetadataJournal::truncate(const string &path)
+{
+	FILE *f = fopen(path.c_str(), "wb");
+	if (f == nullptr) {
+		return false;
+	}
+	fclose(f);
+	return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FeatureStore.h"
+
+//One edit of one metadata cell, keyed by file ID so it survives store rewrites
+struct JournalEntry
+{
+	int fileID;
+	FeatureColumn column;
+	int intValue;
+	float floatValue;
+	std::string stringValue;
+};
+
+//Write-behind journal for user edits (rate). Callers only queue the
+//entry; a background thread appends it to the journal file and syncs it. Every
+//COMPACT_EVERY entries the journal is folded into the feature store with in-place
+//cell patches, the store is synced and the journal keeps only the edits that
+//could not be patched. At startup the journal is replayed by the gallery, so
+//edits not yet compacted are not lost after a crash.
+//
+//Record: uint32 length | uint32 checksum | int32 fileID | uint16 column | uint16 type | value
+//A torn record at the end of the file fails the checksum and ends the replay.
+class MetadataJournal
+{
+public:
+	static const size_t COMPACT_EVERY = 2048;
+
+	MetadataJournal();
+	~MetadataJournal();							//Writes everything queued, then stops
+
+	//Start background writer. store may be nullptr (journal only, no compaction)
+	bool open(const std::string &path, FeatureStore *store);
+	void close();
+
+	void setInt(int fileID, FeatureColumn column, int value);
+	void flush();								//Block until queued entries are on disk
+
+	//Read all valid entries, in order. False if file exists but can't be read
+	static bool read(const std::string &path, std::vector<JournalEntry> &entries);
+	static bool truncate(const std::string &path);
+
+private:
+	MetadataJournal(const MetadataJournal &);
+	MetadataJournal &operator=(const MetadataJournal &);
+
+	void push(const JournalEntry &entry);
+	void writer();
+	bool append(const std::vector<JournalEntry> &batch);
+	void compact();
+	bool rewrite(const std::vector<JournalEntry> &entries);
+
+	std::string journalPath;
+	FeatureStore *featureStore;
+	FILE *file;
+	std::thread thread;
+	std::mutex queueMutex;
+	std::condition_variable queued;
+	std::condition_variable written;
+	std::vector<JournalEntry> queue;
+	std::vector<JournalEntry> uncompacted;		//Entries in journal file since open, applied on compact
+	size_t writing;								//Entries taken by writer, not yet on disk
+	bool stopping;
+};
@@ -0,0 +1,243 @@
+#include "PreviewPool.h"
+#include <opencv2/opencv.hpp>
+
+#include <chrono>
+
+using namespace cv;
+using namespace std::chrono;
+
+PreviewPool::PreviewPool(size_t count, int width, int height)
+	: shown(nullptr), selections(0), previewWidth(width), previewHeight(height)
+{
+	for (size_t i = 0; i < max((size_t)1, count); ++i) {
+		Decoder *d = new Decoder();
+		d->request = 0;
+		d->playing = false;
+		d->stopping = false;
+		d->frameNew = false;
+		d->frameNumber = 0;
+		d->frameCount = 0;
+		d->failed = false;
+		d->file = -1;
+		d->lastSelected = 0;
+		d->hasFrame = false;
+		d->shownNumber = 0;
+		d->shownCount = 0;
+		d->worker = std::thread(&PreviewPool::run, this, d);
+		decoders.push_back(d);
+	}
+}
+
+PreviewPool::~PreviewPool()
+{
+	for (Decoder *d : decoders) {
+		{
+			std::lock_guard<std::mutex> lock(d->lock);
+			d->stopping = true;
+		}
+		d->wake.notify_one();
+	}
+	for (Decoder *d : decoders) {
+		d->worker.join();
+		delete d;
+	}
+}
+
+void PreviewPool::select(const vector<pair<int, string> > &files)
+{
+	if (files.empty()) {
+		return;
+	}
+	selections++;
+	for (size_t f = files.size(); f-- > 0;) {		//Selected clip last, most recent
+		Decoder *d = acquire(files[f].first, files[f].second, files);
+		if (d != nullptr) {
+			d->lastSelected = selections;
+		}
+	}
+
+	Decoder *next = nullptr;
+	for (Decoder *d : decoders) {
+		if (d->file == files[0].first) {
+			next = d;
+		}
+	}
+	if (shown != nullptr && shown != next) {
+		setPlaying(false);						//Previous clip stays where it was
+	}
+	shown = next;
+}
+
+//Decoder already on the file, else the least recently selected one not kept
+PreviewPool::Decoder *PreviewPool::acquire(int file, const string &path, const vector<pair<int, string> > &keep)
+{
+	Decoder *reuse = nullptr;
+	for (Decoder *d : decoders) {
+		if (d->file == file) {
+			return d;
+		}
+		bool kept = false;
+		for (const pair<int, string> &k : keep) {
+			kept = kept || d->file == k.first;
+		}
+		if (!kept && (reuse == nullptr || d->lastSelected < reuse->lastSelected)) {
+			reuse = d;
+		}
+	}
+	if (reuse == nullptr) {
+		return nullptr;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(reuse->lock);
+		reuse->path = ofToDataPath(path, true);
+		reuse->request++;
+		reuse->playing = false;
+		reuse->frameNew = false;
+		reuse->failed = false;
+	}
+	reuse->wake.notify_one();
+	reuse->file = file;
+	reuse->hasFrame = false;
+	reuse->shownNumber = 0;
+	reuse->shownCount = 0;
+	return reuse;
+}
+
+void PreviewPool::setPlaying(bool play)
+{
+	if (shown == nullptr) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(shown->lock);
+		if (shown->playing == play) {
+			return;
+		}
+		shown->playing = play;
+	}
+	shown->wake.notify_one();
+}
+
+void PreviewPool::update()
+{
+	for (Decoder *d : decoders) {
+		Mat frame;
+		{
+			std::lock_guard<std::mutex> lock(d->lock);
+			if (!d->frameNew) {
+				continue;
+			}
+			frame = d->frame;					//Decoder writes a new Mat for every frame
+			d->frameNew = false;
+			d->shownNumber = d->frameNumber;
+			d->shownCount = d->frameCount;
+		}
+		d->pixels.setFromPixels(frame.data, frame.cols, frame.rows, OF_IMAGE_COLOR);
+		d->texture.loadData(d->pixels);
+		d->hasFrame = true;
+	}
+}
+
+void PreviewPool::draw(ofRectangle space, ofTrueTypeFont *text)
+{
+	if (shown == nullptr) {
+		return;
+	}
+	if (!shown->hasFrame) {
+		ofSetColor(0);
+		ofDrawRectangle(space);
+		ofSetColor(255);
+		text->drawString("loading...", space.x, space.y - 3);
+		return;
+	}
+	shown->texture.draw(space.x, space.y, space.width, space.height);
+	text->drawString(ofToString(shown->shownNumber) + " / " + ofToString(shown->shownCount), space.x, space.y - 3);
+}
+
+void PreviewPool::run(Decoder *d)
+{
+	VideoCapture capture;
+	unsigned served = 0;
+	bool opened = false;
+	steady_clock::duration period = milliseconds(40);
+	steady_clock::time_point due = steady_clock::now();
+
+	//Next frame as RGB at preview size, from the start again at the end
+	auto decode = [&](Mat &rgb, int &number) {
+		Mat frame;
+		if (!capture.read(frame)) {
+			capture.set(CV_CAP_PROP_POS_FRAMES, 0);
+			if (!capture.read(frame)) {
+				return false;
+			}
+		}
+		number = (int)capture.get(CV_CAP_PROP_POS_FRAMES);
+		double scale = min(1.0, min((double)previewWidth / frame.cols, (double)previewHeight / frame.rows));
+		if (scale < 1) {
+			resize(frame, frame, Size(max(1, (int)(frame.cols * scale)), max(1, (int)(frame.rows * scale))), 0, 0, INTER_AREA);
+		}
+		cvtColor(frame, rgb, CV_BGR2RGB);
+		return true;
+	};
+
+	std::unique_lock<std::mutex> lock(d->lock);
+	while (!d->stopping) {
+		if (d->request != served) {
+			served = d->request;
+			string path = d->path;
+			lock.unlock();
+
+			capture.release();
+			opened = capture.open(path);
+			Mat rgb;
+			int number = 0;
+			bool decoded = opened && decode(rgb, number);
+			int count = opened ? (int)capture.get(CV_CAP_PROP_FRAME_COUNT) : 0;
+			double fps = opened ? capture.get(CV_CAP_PROP_FPS) : 0;
+			period = duration_cast<steady_clock::duration>(duration<double>(fps > 0 && fps < 240 ? 1.0 / fps : 0.04));
+			if (!decoded) {
+				cout << " [!] preview not opened: " << path << endl;
+			}
+
+			lock.lock();
+			if (d->request == served) {			//Not replaced meanwhile
+				d->failed = !decoded;
+				if (decoded) {
+					d->frame = rgb;
+					d->frameNumber = number;
+					d->frameCount = count;
+					d->frameNew = true;
+				}
+			}
+			due = steady_clock::now() + period;
+			continue;
+		}
+
+		if (d->playing && opened && !d->failed) {
+			steady_clock::time_point now = steady_clock::now();
+			if (now < due) {
+				d->wake.wait_until(lock, due);
+				continue;
+			}
+			lock.unlock();
+			Mat rgb;
+			int number = 0;
+			bool decoded = decode(rgb, number);
+			lock.lock();
+			if (d->request == served && decoded) {
+				d->frame = rgb;
+				d->frameNumber = number;
+				d->frameNew = true;
+			}
+			due += period;
+			now = steady_clock::now();
+			if (due < now) {
+				due = now + period;				//No catching up after a slow frame or a pause
+			}
+			continue;
+		}
+
+		d->wake.wait(lock);
+	}
+}
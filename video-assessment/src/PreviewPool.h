@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ofMain.h"
+#include "opencv2/core.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//Clip preview next to the metadata panel. A few decoders, each on its own
+//thread, open clips in the background: the selected one and its neighbours in
+//the grid, so their first frame is ready before they are clicked. Decoders are
+//reused for the next selection, least recently selected first. Frames are
+//scaled down to the preview size by the decoder; the GL thread only uploads them.
+class PreviewPool
+{
+public:
+	PreviewPool(size_t decoders = 5, int width = 320, int height = 240);
+	~PreviewPool();								//Stops the decoders
+
+	//files[0] is shown, the others are opened and kept paused. (file index, path)
+	void select(const vector<pair<int, string> > &files);
+	void setPlaying(bool play);					//Selected clip
+	void update();								//Upload new frames, GL thread
+	void draw(ofRectangle space, ofTrueTypeFont *text);	//Placeholder until the first frame
+
+private:
+	PreviewPool(const PreviewPool &);
+	PreviewPool &operator=(const PreviewPool &);
+
+	struct Decoder
+	{
+		std::thread worker;
+		std::mutex lock;
+		std::condition_variable wake;
+
+		//Written by the GL thread
+		string path;
+		unsigned request;						//Bumped to open path
+		bool playing;
+		bool stopping;
+
+		//Written by the decoder
+		cv::Mat frame;							//RGB, preview size
+		bool frameNew;
+		int frameNumber;
+		int frameCount;
+		bool failed;
+
+		//GL thread only
+		int file;								//-1 = free
+		unsigned lastSelected;
+		ofPixels pixels;
+		ofTexture texture;
+		bool hasFrame;
+		int shownNumber;
+		int shownCount;
+	};
+
+	void run(Decoder *d);
+	Decoder *acquire(int file, const string &path, const vector<pair<int, string> > &keep);
+
+	vector<Decoder *> decoders;
+	Decoder *shown;
+	unsigned selections;
+	int previewWidth;
+	int previewHeight;
+};
@@ -0,0 +1,148 @@
+#include "RffModel.h"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+using namespace cv::ml;
+
+RffModel::RffModel()
+{
+	clear();
+}
+
+//Draw D random features and fold the support vectors of decision function 0 into them
+bool RffModel::build(const Ptr<SVM> &svm, int components, unsigned seed)
+{
+	clear();
+	if (svm.empty() || !svm->isTrained() || svm->getKernelType() != SVM::RBF || components <= 0) {
+		cout << " [!] RffModel: needs a trained RBF SVM and at least one component" << endl;
+		return false;
+	}
+	Mat sv = svm->getSupportVectors();
+	Mat alpha, svidx;
+	double rho = svm->getDecisionFunction(0, alpha, svidx);
+	alpha.convertTo(alpha, CV_64F);
+	if (sv.empty() || sv.type() != CV_32FC1 || alpha.total() == 0) {
+		cout << " [!] RffModel: model has no support vectors" << endl;
+		return false;
+	}
+
+	int dims = sv.cols;
+	mt19937 random(seed);
+	normal_distribution<double> frequency(0.0, sqrt(2.0 * svm->getGamma()));
+	uniform_real_distribution<double> offset(0.0, 2.0 * CV_PI);
+	projection.create(dims, components, CV_32FC1);
+	phase.create(1, components, CV_32FC1);
+	for (int i = 0; i < dims; ++i) {
+		float *row = projection.ptr<float>(i);
+		for (int k = 0; k < components; ++k) {
+			row[k] = (float)frequency(random);
+		}
+	}
+	float *b = phase.ptr<float>(0);
+	for (int k = 0; k < components; ++k) {
+		b[k] = (float)offset(random);
+	}
+
+	//weight_k = 2/D sum_i alpha_i cos(w_k.sv_i + b_k)
+	Mat svProjected;
+	gemm(sv, projection, 1, noArray(), 0, svProjected);
+	vector<double> sums(components, 0);
+	for (int i = 0; i < (int)alpha.total(); ++i) {
+		int row = svidx.empty() ? i : svidx.at<int>(i);
+		double a = alpha.at<double>(i);
+		const float *p = svProjected.ptr<float>(row);
+		for (int k = 0; k < components; ++k) {
+			sums[k] += a * cos((double)p[k] + b[k]);
+		}
+	}
+	weights.create(1, components, CV_32FC1);
+	float *w = weights.ptr<float>(0);
+	for (int k = 0; k < components; ++k) {
+		w[k] = (float)(sums[k] * 2.0 / components);
+	}
+	bias = (float)-rho;
+
+	//Which label a positive decision means: take the mapping that agrees best with
+	//the exact model on its own support vectors
+	Mat exact, values;
+	svm->predict(sv, exact);
+	decision(sv, values);
+	float low = exact.at<float>(0, 0);
+	float high = low;
+	for (int i = 0; i < exact.rows; ++i) {
+		low = min(low, exact.at<float>(i, 0));
+		high = max(high, exact.at<float>(i, 0));
+	}
+	int lowPositive = 0;
+	for (int i = 0; i < exact.rows; ++i) {
+		float label = values.at<float>(i, 0) > 0 ? low : high;
+		if (label == exact.at<float>(i, 0)) lowPositive++;
+	}
+	positiveLabel = (lowPositive * 2 >= exact.rows) ? low : high;
+	negativeLabel = (positiveLabel == low) ? high : low;
+	return true;
+}
+
+void RffModel::clear()
+{
+	projection.release();
+	phase.release();
+	weights.release();
+	bias = 0;
+	positiveLabel = 0;
+	negativeLabel = 0;
+}
+
+bool RffModel::empty() const
+{
+	return weights.empty();
+}
+
+int RffModel::inputs() const
+{
+	return projection.rows;
+}
+
+int RffModel::components() const
+{
+	return weights.cols;
+}
+
+//One gemm for all projections, then a contiguous cos/multiply-add loop per row
+void RffModel::decision(const Mat &samples, Mat &values)
+{
+	values.create(samples.rows, 1, CV_32FC1);
+	if (empty() || samples.type() != CV_32FC1 || samples.cols != inputs()) {
+		values.setTo(0);
+		return;
+	}
+	gemm(samples, projection, 1, noArray(), 0, projected);
+	int count = components();
+	const float *b = phase.ptr<float>(0);
+	const float *w = weights.ptr<float>(0);
+	for (int r = 0; r < samples.rows; ++r) {
+		float *p = projected.ptr<float>(r);
+		for (int k = 0; k < count; ++k) {
+			p[k] = w[k] * std::cos(p[k] + b[k]);
+		}
+		float sum = bias;
+		for (int k = 0; k < count; ++k) {
+			sum += p[k];
+		}
+		values.at<float>(r, 0) = sum;
+	}
+}
+
+void RffModel::predict(const Mat &samples, Mat &labels)
+{
+	decision(samples, labels);
+	for (int r = 0; r < labels.rows; ++r) {
+		float &value = labels.at<float>(r, 0);
+		value = value > 0 ? positiveLabel : negativeLabel;
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <opencv2/ml.hpp>
+
+//Random Fourier feature approximation of a trained two-class RBF SVM, for bulk
+//triage. exp(-g|x-y|^2) ~ z(x).z(y) with z(x) = sqrt(2/D) cos(Wx + b),
+//W ~ N(0, 2g), b ~ U(0, 2pi), so the support vector sum folds into D weights
+//and scoring costs one matrix product plus D cosines per sample, whatever the
+//number of support vectors.
+class RffModel
+{
+public:
+	RffModel();
+
+	bool build(const cv::Ptr<cv::ml::SVM> &svm, int components, unsigned seed = 1);
+	void clear();
+	bool empty() const;
+	int inputs() const;
+	int components() const;
+
+	void decision(const cv::Mat &samples, cv::Mat &values);	//N x inputs CV_32FC1 -> N x 1 decision values
+	void predict(const cv::Mat &samples, cv::Mat &labels);		//Same labels as SVM::predict, CV_32FC1
+
+private:
+	cv::Mat projection;				//inputs x D, W transposed
+	cv::Mat phase;					//1 x D, b
+	cv::Mat weights;				//1 x D, sqrt(2/D) sum(alpha_i z(sv_i))
+	float bias;						//-rho
+	float positiveLabel;			//Label of decision > 0
+	float negativeLabel;
+	cv::Mat projected;				//Scratch N x D
+};
@@ -0,0 +1,346 @@
+#include "SimilarityIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define SIMILARITY_INDEX_SSE 1
+#include <xmmintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+	const float slack = 1e-4f;
+
+	typedef pair<float, int> Candidate;		//Distance, row. Smaller is better, ties by row
+
+	//Best k candidates so far, worst on top
+	struct Search
+	{
+		size_t k;
+		priority_queue<Candidate> best;
+
+		float tau() const
+		{
+			return best.size() < k ? numeric_limits<float>::infinity() : best.top().first;
+		}
+
+		void offer(float d, int row)
+		{
+			Candidate c(d, row);
+			if (best.size() < k) {
+				best.push(c);
+			}
+			else if (c < best.top()) {
+				best.pop();
+				best.push(c);
+			}
+		}
+	};
+
+	void toMatches(priority_queue<Candidate> &best, int facets, vector<SimilarityIndex::Match> &matches)
+	{
+		matches.resize(best.size());
+		for (size_t i = matches.size(); i-- > 0; best.pop()) {
+			matches[i].row = best.top().second;
+			matches[i].similarity = 1.0f - best.top().first / facets;
+		}
+	}
+}
+
+SimilarityIndex::SimilarityIndex() : count(0), stride(0), seed(1)
+{
+}
+
+void SimilarityIndex::resize(size_t rows)
+{
+	count = rows;
+	stride = (rows + 3) / 4 * 4;
+	values.assign(stride * COLUMNS, 0.0f);
+	missing.assign(rows, 0);
+	clearTrees();
+}
+
+//Missing facets are stored as 0, so no NaN gets into a distance
+void SimilarityIndex::setRow(size_t row, const float colorMoments[6], const int edges[17], float entropy, float motion)
+{
+	unsigned lacks = 0;
+	for (int c = 0; c < COLOR_COLUMNS; ++c) {
+		if (colorMoments[c] != colorMoments[c]) lacks |= COLOR;
+	}
+	for (int e = 0; e < EDGE_COLUMNS; ++e) {
+		if (edges[e] < 0) lacks |= EDGES;
+	}
+	if (entropy != entropy) lacks |= ENTROPY;
+	if (motion != motion) lacks |= MOTION;
+	missing[row] = (unsigned char)lacks;
+
+	for (int c = 0; c < COLOR_COLUMNS; ++c) {
+		values[c * stride + row] = (lacks & COLOR) ? 0.0f : colorMoments[c];
+	}
+	for (int e = 0; e < EDGE_COLUMNS; ++e) {
+		values[(COLOR_COLUMNS + e) * stride + row] = (lacks & EDGES) ? 0.0f : (float)edges[e];
+	}
+	values[(COLUMNS - 2) * stride + row] = (lacks & ENTROPY) ? 0.0f : entropy;
+	values[(COLUMNS - 1) * stride + row] = (lacks & MOTION) ? 0.0f : motion;
+	if (!packed.empty()) {
+		clearTrees();
+	}
+}
+
+void SimilarityIndex::clearTrees()
+{
+	for (int m = 0; m < 16; ++m) {
+		trees[m].clear();
+	}
+	packed.clear();
+}
+
+size_t SimilarityIndex::rows() const
+{
+	return count;
+}
+
+unsigned SimilarityIndex::missingFacets(int row) const
+{
+	return missing[row];
+}
+
+const float *SimilarityIndex::column(int c) const
+{
+	return values.data() + c * stride;
+}
+
+int SimilarityIndex::facetCount(unsigned facets)
+{
+	return (int)((facets & COLOR) != 0) + ((facets & EDGES) != 0) + ((facets & ENTROPY) != 0) + ((facets & MOTION) != 0);
+}
+
+//Same operations in the same order as the SSE pass, so both give equal distances
+float SimilarityIndex::distance(int a, int b, unsigned facets) const
+{
+	if (!packed.empty()) {
+		return distance(&packed[a * COLUMNS], &packed[b * COLUMNS], facets);
+	}
+	float x[COLUMNS], y[COLUMNS];
+	for (int c = 0; c < COLUMNS; ++c) {
+		x[c] = column(c)[a];
+		y[c] = column(c)[b];
+	}
+	return distance(x, y, facets);
+}
+
+float SimilarityIndex::distance(const float *a, const float *b, unsigned facets)
+{
+	float d = 0;
+	if (facets & COLOR) {
+		float sum = 0;
+		for (int c = 0; c < COLOR_COLUMNS; ++c) {
+			float t = a[c] - b[c];
+			sum = sum + t * t;
+		}
+		d = d + sqrt(sum) / 10.0f;
+	}
+	if (facets & EDGES) {
+		float mismatches = 0;
+		for (int e = COLOR_COLUMNS; e < COLOR_COLUMNS + EDGE_COLUMNS - 1; ++e) {
+			mismatches = mismatches + (a[e] != b[e] ? 1.0f : 0.0f);
+		}
+		int global = COLOR_COLUMNS + EDGE_COLUMNS - 1;
+		mismatches = mismatches + (a[global] != b[global] ? 8.0f : 0.0f);
+		d = d + mismatches / 24.0f;
+	}
+	if (facets & ENTROPY) {
+		d = d + fabs(a[COLUMNS - 2] - b[COLUMNS - 2]);
+	}
+	if (facets & MOTION) {
+		d = d + fabs(a[COLUMNS - 1] - b[COLUMNS - 1]);
+	}
+	return d;
+}
+
+void SimilarityIndex::nearest(int query, unsigned facets, size_t k, vector<Match> &matches)
+{
+	if (count >= treeRows) {
+		nearestTree(query, facets, k, matches);
+	}
+	else {
+		nearestLinear(query, facets, k, matches);
+	}
+}
+
+//Distance to every row, 4 rows per step, then the k smallest
+void SimilarityIndex::nearestLinear(int query, unsigned facets, size_t k, vector<Match> &matches) const
+{
+	matches.clear();
+	facets &= 15;
+	if (query >= 0 && (size_t)query < count) {
+		facets &= ~missing[query];
+	}
+	if (query < 0 || (size_t)query >= count || facets == 0 || k == 0) {
+		return;
+	}
+	vector<float> d(stride, 0.0f);
+	size_t r = 0;
+#ifdef SIMILARITY_INDEX_SSE
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	for (; r < stride; r += 4) {
+		__m128 sum = _mm_setzero_ps();
+		if (facets & COLOR) {
+			__m128 squares = _mm_setzero_ps();
+			for (int c = 0; c < COLOR_COLUMNS; ++c) {
+				__m128 t = _mm_sub_ps(_mm_set1_ps(column(c)[query]), _mm_loadu_ps(column(c) + r));
+				squares = _mm_add_ps(squares, _mm_mul_ps(t, t));
+			}
+			sum = _mm_add_ps(sum, _mm_div_ps(_mm_sqrt_ps(squares), _mm_set1_ps(10.0f)));
+		}
+		if (facets & EDGES) {
+			__m128 mismatches = _mm_setzero_ps();
+			for (int e = 0; e < EDGE_COLUMNS - 1; ++e) {
+				const float *edge = column(COLOR_COLUMNS + e);
+				__m128 differ = _mm_cmpneq_ps(_mm_set1_ps(edge[query]), _mm_loadu_ps(edge + r));
+				mismatches = _mm_add_ps(mismatches, _mm_and_ps(differ, _mm_set1_ps(1.0f)));
+			}
+			const float *global = column(COLOR_COLUMNS + EDGE_COLUMNS - 1);
+			__m128 differ = _mm_cmpneq_ps(_mm_set1_ps(global[query]), _mm_loadu_ps(global + r));
+			mismatches = _mm_add_ps(mismatches, _mm_and_ps(differ, _mm_set1_ps(8.0f)));
+			sum = _mm_add_ps(sum, _mm_div_ps(mismatches, _mm_set1_ps(24.0f)));
+		}
+		if (facets & ENTROPY) {
+			const float *entropy = column(COLUMNS - 2);
+			__m128 t = _mm_sub_ps(_mm_set1_ps(entropy[query]), _mm_loadu_ps(entropy + r));
+			sum = _mm_add_ps(sum, _mm_andnot_ps(sign, t));
+		}
+		if (facets & MOTION) {
+			const float *motion = column(COLUMNS - 1);
+			__m128 t = _mm_sub_ps(_mm_set1_ps(motion[query]), _mm_loadu_ps(motion + r));
+			sum = _mm_add_ps(sum, _mm_andnot_ps(sign, t));
+		}
+		_mm_storeu_ps(&d[r], sum);
+	}
+#else
+	for (; r < count; ++r) {
+		d[r] = distance(query, (int)r, facets);
+	}
+#endif
+
+	vector<int> order;
+	order.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		if ((missing[i] & facets) == 0) order.push_back((int)i);	//Always has the query
+	}
+	auto closer = [&d](int a, int b) { return d[a] != d[b] ? d[a] < d[b] : a < b; };
+	size_t top = min(k, order.size());
+	nth_element(order.begin(), order.begin() + (top - 1), order.end(), closer);
+	sort(order.begin(), order.begin() + top, closer);
+	int n = facetCount(facets);
+	matches.resize(top);
+	for (size_t i = 0; i < top; ++i) {
+		matches[i].row = order[i];
+		matches[i].similarity = 1.0f - d[order[i]] / n;
+	}
+}
+
+//Vantage point tree search: skip a side when no row in it can beat the k-th best
+void SimilarityIndex::nearestTree(int query, unsigned facets, size_t k, vector<Match> &matches)
+{
+	matches.clear();
+	facets &= 15;
+	if (query >= 0 && (size_t)query < count) {
+		facets &= ~missing[query];
+	}
+	if (query < 0 || (size_t)query >= count || facets == 0 || k == 0) {
+		return;
+	}
+	if (trees[facets].empty()) {
+		buildTree(facets);
+	}
+	const vector<Node> &tree = trees[facets];
+	Search search = { k, priority_queue<Candidate>() };
+	vector<pair<int, float> > pending(1, make_pair(0, 0.0f));	//Node index, lower bound of its distances. Depth first
+	while (!pending.empty()) {
+		pair<int, float> next = pending.back();
+		pending.pop_back();
+		if (next.second > search.tau() + slack) {
+			continue;							//Bound got beaten since the node was queued
+		}
+		const Node &node = tree[next.first];
+		float d = distance(query, node.row, facets);
+		search.offer(d, node.row);
+		float tau = search.tau() + slack;		//Rounding must not cut off ties
+		bool visitInside = node.inside >= 0 && d - tau <= node.radius;
+		bool visitOutside = node.outside >= 0 && d + tau >= node.radius;
+		pair<int, float> inside(node.inside, max(0.0f, d - node.radius));
+		pair<int, float> outside(node.outside, max(0.0f, node.radius - d));
+		if (d < node.radius) {					//Nearer side last, so it's visited first
+			if (visitOutside) pending.push_back(outside);
+			if (visitInside) pending.push_back(inside);
+		}
+		else {
+			if (visitInside) pending.push_back(inside);
+			if (visitOutside) pending.push_back(outside);
+		}
+	}
+	toMatches(search.best, facetCount(facets), matches);
+}
+
+void SimilarityIndex::buildTree(unsigned facets)
+{
+	if (packed.empty()) {						//Tree distances read whole rows, so keep them together
+		packed.resize(count * COLUMNS);
+		for (size_t r = 0; r < count; ++r) {
+			for (int c = 0; c < COLUMNS; ++c) {
+				packed[r * COLUMNS + c] = column(c)[r];
+			}
+		}
+	}
+	vector<Node> &tree = trees[facets];
+	tree.clear();
+	tree.reserve(count);
+	vector<pair<float, int> > items;			//Rows that have all the facets
+	items.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		if ((missing[i] & facets) == 0) items.push_back(make_pair(0.0f, (int)i));
+	}
+	buildNode(tree, items, 0, items.size(), facets);
+	cout << " [*] Similarity index built for facets " << facets << ", " << items.size() << " files" << endl;
+}
+
+//Random vantage row, the others split at their median distance to it
+int SimilarityIndex::buildNode(vector<Node> &tree, vector<pair<float, int> > &items, size_t first, size_t last, unsigned facets)
+{
+	if (first >= last) {
+		return -1;
+	}
+	uint64_t hash = (seed + first) * 0x9e3779b97f4a7c15ull;	//splitmix64 finaliser
+	hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+	hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+	hash ^= hash >> 31;
+	size_t vantage = first + (size_t)(hash % (last - first));
+	swap(items[first], items[vantage]);
+	int index = (int)tree.size();
+	Node node = { items[first].second, 0.0f, -1, -1 };
+	tree.push_back(node);
+	if (last - first == 1) {
+		return index;
+	}
+
+	for (size_t i = first + 1; i < last; ++i) {
+		items[i].first = distance(node.row, items[i].second, facets);
+	}
+	size_t middle = first + 1 + (last - first - 1) / 2;
+	nth_element(items.begin() + first + 1, items.begin() + middle, items.begin() + last);
+	float radius = items[middle].first;
+	int inside = buildNode(tree, items, first + 1, middle, facets);
+	int outside = buildNode(tree, items, middle, last, facets);
+	tree[index].radius = radius;
+	tree[index].inside = inside;
+	tree[index].outside = outside;
+	return index;
+}
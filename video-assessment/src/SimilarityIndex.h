@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+//Features behind the similarity mode of filtersPanel, kept in memory, and the
+//k most similar files to one of them. Each facet similarity is 1 - a distance:
+//  colour   |moments a - moments b| / 10 (6 colour moments)
+//  edges    mismatching edge histogram cells / 24 (16 cells, global orientation x8)
+//  entropy  |entropy a - entropy b|
+//  motion   |motion a - motion b|
+//and the similarity is 1 - the summed distance / enabled facets. The summed
+//distance is a metric, so large catalogs are searched with a vantage point tree
+//(exact, one per facet combination, built on first use) and small ones with an
+//SSE pass over all files.
+//A facet with a value not computed (NaN, edges < 0) is missing from that row:
+//queries leave out the facets the query row is missing, and rows missing one of
+//the remaining facets are not matched.
+class SimilarityIndex
+{
+public:
+	enum Facet
+	{
+		COLOR = 1,
+		EDGES = 2,
+		ENTROPY = 4,
+		MOTION = 8
+	};
+
+	struct Match
+	{
+		int row;
+		float similarity;
+	};
+
+	enum { COLOR_COLUMNS = 6, EDGE_COLUMNS = 17, COLUMNS = COLOR_COLUMNS + EDGE_COLUMNS + 2 };	//Values per row
+
+	SimilarityIndex();
+
+	void resize(size_t rows);
+	void setRow(size_t row, const float colorMoments[6], const int edges[17], float entropy, float motion);	//edges[16] = global
+	size_t rows() const;
+	unsigned missingFacets(int row) const;
+
+	//k most similar rows to query, most similar first, ties by row. query itself included.
+	//Facets the query is missing are dropped first, none left = no matches
+	void nearest(int query, unsigned facets, size_t k, std::vector<Match> &matches);
+	void nearestLinear(int query, unsigned facets, size_t k, std::vector<Match> &matches) const;
+	void nearestTree(int query, unsigned facets, size_t k, std::vector<Match> &matches);
+
+	float distance(int a, int b, unsigned facets) const;
+	static float distance(const float *a, const float *b, unsigned facets);	//Rows of COLUMNS values
+	static int facetCount(unsigned facets);
+
+	static const size_t treeRows = 100000;		//Catalogs from this size are searched with the tree
+
+private:
+
+	struct Node
+	{
+		int row;
+		float radius;							//Rows inside are at most this far, outside at least
+		int inside;								//Node indexes, -1 = none
+		int outside;
+	};
+
+	const float *column(int c) const;
+	void clearTrees();
+	void buildTree(unsigned facets);
+	int buildNode(std::vector<Node> &tree, std::vector<std::pair<float, int> > &items, size_t first, size_t last, unsigned facets);
+
+	size_t count;
+	size_t stride;								//count rounded up to 4
+	std::vector<float> values;					//Column after column: colour, edges, entropy, motion. Missing ones 0
+	std::vector<unsigned char> missing;			//Facet bits per row
+	std::vector<float> packed;					//Row after row, only while a tree exists
+	std::vector<Node> trees[16];				//By facet mask, empty until needed
+	unsigned seed;
+};
@@ -0,0 +1,186 @@
+#include "SvmTrainer.h"
+#include "CsvTable.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+
+using namespace std;
+
+namespace {
+
+	struct Fold
+	{
+		Mat trainData;
+		Mat trainLabels;
+		Mat testData;
+		Mat testLabels;
+	};
+
+	void copyRows(const Mat &from, const vector<int> &rows, Mat &to)
+	{
+		to.create((int)rows.size(), from.cols, from.type());
+		for (size_t r = 0; r < rows.size(); ++r) {
+			from.row(rows[r]).copyTo(to.row((int)r));
+		}
+	}
+}
+
+bool SvmTrainer::load(const mlclass::ModelSource &source)
+{
+	CsvTable samplesCsv;
+	CsvTable labelsCsv;
+	if (!samplesCsv.load(source.featureVector) || !labelsCsv.load(source.binaryScores)) {
+		cout << " [!] training data missing: " << source.featureVector << " " << source.binaryScores << endl;
+		return false;
+	}
+	int rows = (int)min(samplesCsv.rows(), labelsCsv.rows());
+	if (rows == 0) {
+		cout << " [!] no training samples in " << source.featureVector << endl;
+		return false;
+	}
+	int cols = (int)samplesCsv.cells(0);
+	if (samplesCsv.rows() != labelsCsv.rows()) {
+		cout << " [!] " << samplesCsv.rows() << " samples but " << labelsCsv.rows() << " labels, using " << rows << endl;
+	}
+
+	data.create(rows, cols, CV_32FC1);
+	labels.create(rows, 1, CV_32SC1);
+	for (int i = 0; i < rows; ++i) {
+		float *row = data.ptr<float>(i);
+		for (int j = 0; j < cols; ++j) {
+			row[j] = (float)samplesCsv.get(i, j);
+		}
+		labels.at<int>(i, 0) = labelsCsv.getInt(i, 0);
+	}
+
+	if (source.maxminPath.empty()) {
+		ranges.assign(2, vector<double>(cols, 0));
+		fill(ranges[0].begin(), ranges[0].end(), 1.0);		//Identity normalisation
+		return true;
+	}
+	return mlclass::readMaxMin(source.maxminPath, cols, ranges);
+}
+
+int SvmTrainer::samples() const
+{
+	return data.rows;
+}
+
+int SvmTrainer::features() const
+{
+	return data.cols;
+}
+
+const vector< vector<double> > &SvmTrainer::maxmin() const
+{
+	return ranges;
+}
+
+vector<SvmTrainer::Candidate> SvmTrainer::gridCandidates(double cMin, double cMax, double gMin, double gMax, double log2Step)
+{
+	vector<Candidate> candidates;
+	double step = log2Step > 0 ? log2Step : 1;
+	for (double c = log2(cMin); c <= log2(cMax) + 1e-9; c += step) {
+		for (double g = log2(gMin); g <= log2(gMax) + 1e-9; g += step) {
+			Candidate candidate = { pow(2.0, c), pow(2.0, g), 0, 0, 0 };
+			candidates.push_back(candidate);
+		}
+	}
+	return candidates;
+}
+
+vector<SvmTrainer::Candidate> SvmTrainer::randomCandidates(double cMin, double cMax, double gMin, double gMax, int trials, unsigned seed)
+{
+	mt19937 random(seed);
+	uniform_real_distribution<double> logC(log2(cMin), log2(cMax));
+	uniform_real_distribution<double> logG(log2(gMin), log2(gMax));
+	vector<Candidate> candidates;
+	for (int t = 0; t < trials; ++t) {
+		Candidate candidate = { pow(2.0, logC(random)), pow(2.0, logG(random)), 0, 0, 0 };
+		candidates.push_back(candidate);
+	}
+	return candidates;
+}
+
+bool SvmTrainer::crossValidate(vector<Candidate> &candidates, int folds, unsigned seed, ThreadPool &pool)
+{
+	if (folds < 2 || data.rows < folds) {
+		cout << " [!] need at least 2 folds and one sample per fold" << endl;
+		return false;
+	}
+
+	//Stratified: shuffle each class, then deal its samples over the folds
+	map<int, vector<int> > byLabel;
+	for (int i = 0; i < data.rows; ++i) {
+		byLabel[labels.at<int>(i, 0)].push_back(i);
+	}
+	mt19937 random(seed);
+	vector<int> foldOf(data.rows, 0);
+	int next = 0;
+	for (auto &label : byLabel) {
+		shuffle(label.second.begin(), label.second.end(), random);
+		for (int i : label.second) {
+			foldOf[i] = next++ % folds;
+		}
+	}
+
+	vector<Fold> splits(folds);
+	for (int f = 0; f < folds; ++f) {
+		vector<int> train, test;
+		for (int i = 0; i < data.rows; ++i) {
+			(foldOf[i] == f ? test : train).push_back(i);
+		}
+		copyRows(data, train, splits[f].trainData);
+		copyRows(labels, train, splits[f].trainLabels);
+		copyRows(data, test, splits[f].testData);
+		copyRows(labels, test, splits[f].testLabels);
+	}
+
+	//One task per (candidate, fold), results reduced afterwards
+	vector<int> correct(candidates.size() * folds, 0);
+	vector<double> elapsed(candidates.size() * folds, 0);
+	pool.parallelFor(correct.size(), [&](size_t task) {
+		const Candidate &candidate = candidates[task / folds];
+		const Fold &fold = splits[task % folds];
+		auto start = chrono::high_resolution_clock::now();
+		try {
+			Ptr<SVM> s = mlclass::createSVM(candidate.C, candidate.G);
+			s->train(fold.trainData, ROW_SAMPLE, fold.trainLabels);
+			Mat predicted;
+			s->predict(fold.testData, predicted);
+			int right = 0;
+			for (int i = 0; i < fold.testData.rows; ++i) {
+				if ((int)predicted.at<float>(i, 0) == fold.testLabels.at<int>(i, 0)) right++;
+			}
+			correct[task] = right;
+		}
+		catch (const cv::Exception &) {
+			correct[task] = 0;			//Degenerate split (one class), counts as all wrong
+		}
+		auto end = chrono::high_resolution_clock::now();
+		elapsed[task] = chrono::duration<double, milli>(end - start).count();
+	});
+
+	for (size_t c = 0; c < candidates.size(); ++c) {
+		candidates[c].correct = 0;
+		candidates[c].trainMs = 0;
+		for (int f = 0; f < folds; ++f) {
+			candidates[c].correct += correct[c * folds + f];
+			candidates[c].trainMs += elapsed[c * folds + f];
+		}
+		candidates[c].accuracy = (double)candidates[c].correct / data.rows;
+	}
+	return true;
+}
+
+Ptr<SVM> SvmTrainer::train(double C, double G)
+{
+	Ptr<SVM> s = mlclass::createSVM(C, G);
+	s->train(data, ROW_SAMPLE, labels);
+	return s;
+}
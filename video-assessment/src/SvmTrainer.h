@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include "mlclass.h"
+
+class ThreadPool;
+
+//k-fold cross-validated search over C and gamma of the RBF SVM used by mlclass.
+//Folds are stratified by label; every (candidate, fold) pair is trained as an
+//independent task on the pool, so the search uses all cores.
+class SvmTrainer
+{
+public:
+	struct Candidate
+	{
+		double C;
+		double G;
+		int correct;				//Test samples classified right, all folds
+		double accuracy;
+		double trainMs;				//Training + testing time summed over folds
+	};
+
+	//Samples, labels and maxmin. Without a maxmin file samples must already be in 0..1
+	bool load(const mlclass::ModelSource &source);
+	int samples() const;
+	int features() const;
+	const vector< vector<double> > &maxmin() const;
+
+	//log2 grid from min to max (inclusive) with step, as in the libsvm guide
+	static vector<Candidate> gridCandidates(double cMin, double cMax, double gMin, double gMax, double log2Step);
+	//Log-uniform random draws in the same ranges
+	static vector<Candidate> randomCandidates(double cMin, double cMax, double gMin, double gMax, int trials, unsigned seed);
+
+	bool crossValidate(vector<Candidate> &candidates, int folds, unsigned seed, ThreadPool &pool);
+	Ptr<SVM> train(double C, double G);		//Final model on all samples
+
+private:
+	Mat data;								//samples x features, CV_32FC1
+	Mat labels;								//samples x 1, CV_32SC1
+	vector< vector<double> > ranges;		//Max row, min row
+};
@@ -0,0 +1,121 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+	active = 0;
+	stopping = false;
+	if (threads == 0) {
+		threads = thread::hardware_concurrency();
+	}
+	if (threads == 0) {
+		threads = 2;
+	}
+	for (unsigned t = 0; t < threads; ++t) {
+		workers.push_back(thread(&ThreadPool::worker, this));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> lock(queueMutex);
+		stopping = true;
+	}
+	taskReady.notify_all();
+	for (size_t t = 0; t < workers.size(); ++t) {
+		workers[t].join();
+	}
+}
+
+void ThreadPool::enqueue(function<void()> task)
+{
+	{
+		lock_guard<mutex> lock(queueMutex);
+		tasks.push_back(move(task));
+	}
+	taskReady.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	unique_lock<mutex> lock(queueMutex);
+	idle.wait(lock, [this] { return tasks.empty() && active == 0; });
+}
+
+unsigned ThreadPool::size() const
+{
+	return (unsigned)workers.size();
+}
+
+void ThreadPool::parallelFor(size_t count, const function<void(size_t)> &body)
+{
+	if (count == 0) {
+		return;
+	}
+	if (count == 1 || workers.size() < 2) {
+		for (size_t i = 0; i < count; ++i) {
+			body(i);
+		}
+		return;
+	}
+
+	//Shared state lives until the last runner is done, wait() is not used so
+	//other tasks in the queue don't delay the caller
+	struct Batch
+	{
+		atomic<size_t> next;
+		size_t remaining;
+		mutex doneMutex;
+		condition_variable done;
+	};
+	shared_ptr<Batch> batch = make_shared<Batch>();
+	batch->next = 0;
+	size_t runners = workers.size() < count ? workers.size() : count;
+	batch->remaining = runners;
+
+	for (size_t r = 0; r < runners; ++r) {
+		enqueue([batch, count, &body] {
+			size_t i;
+			while ((i = batch->next++) < count) {
+				body(i);
+			}
+			lock_guard<mutex> lock(batch->doneMutex);
+			if (--batch->remaining == 0) {
+				batch->done.notify_all();
+			}
+		});
+	}
+
+	unique_lock<mutex> lock(batch->doneMutex);
+	batch->done.wait(lock, [&batch] { return batch->remaining == 0; });
+}
+
+void ThreadPool::worker()
+{
+	for (;;) {
+		function<void()> task;
+		{
+			unique_lock<mutex> lock(queueMutex);
+			taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+			if (tasks.empty()) {
+				return;			//Stopping and nothing left
+			}
+			task = move(tasks.front());
+			tasks.pop_front();
+			active++;
+		}
+		task();
+		{
+			lock_guard<mutex> lock(queueMutex);
+			active--;
+			if (tasks.empty() && active == 0) {
+				idle.notify_all();
+			}
+		}
+	}
+}
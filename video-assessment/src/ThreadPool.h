@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed set of worker threads fed from a FIFO queue
+class ThreadPool
+{
+public:
+	explicit ThreadPool(unsigned threads = 0);	//0 = one per hardware thread
+	~ThreadPool();								//Finishes queued tasks, then joins
+
+	void enqueue(std::function<void()> task);
+	void wait();								//Block until queue is empty and workers idle
+	unsigned size() const;
+
+	//Runs body(0..count-1) on the workers and blocks until all are done.
+	//Indices are handed out one by one, so uneven items balance themselves.
+	void parallelFor(size_t count, const std::function<void(size_t)> &body);
+
+private:
+	ThreadPool(const ThreadPool &);
+	ThreadPool &operator=(const ThreadPool &);
+
+	void worker();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()> > tasks;
+	std::mutex queueMutex;
+	std::condition_variable taskReady;
+	std::condition_variable idle;
+	size_t active;
+	bool stopping;
+};
@@ -0,0 +1,468 @@
+#include "ThumbnailArchive.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+	const char archiveMagic[4] = { 'V', 'Q', 'A', 'T' };
+	const uint64_t tileAlign = 4096;		//Page size, a tile is read in whole pages
+
+	struct ArchiveHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t tileWidth;
+		uint32_t tileHeight;
+		uint32_t reserved;
+		uint64_t indexOffset;
+		uint64_t namesOffset;
+		uint64_t namesLength;
+	};
+
+	struct ArchiveEntry
+	{
+		uint32_t name;						//Offset in names
+		uint32_t page;						//Of the tile, from the start of the file
+		uint16_t width;						//0 x 0: no tile, failed to decode
+		uint16_t height;
+	};
+
+	const ArchiveEntry &entryAt(const char *index, uint32_t e)
+	{
+		return ((const ArchiveEntry *)index)[e];
+	}
+
+	uint64_t alignTile(uint64_t v)
+	{
+		return (v + tileAlign - 1) & ~(tileAlign - 1);
+	}
+
+	bool seekTo(FILE *f, uint64_t offset)
+	{
+#ifdef _WIN32
+		return _fseeki64(f, (__int64)offset, SEEK_SET) == 0;
+#else
+		return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+	}
+
+	bool syncFile(FILE *f)
+	{
+		if (fflush(f) != 0) {
+			return false;
+		}
+#ifdef _WIN32
+		return _commit(_fileno(f)) == 0;
+#else
+		return fsync(fileno(f)) == 0;
+#endif
+	}
+
+	bool replaceFile(const string &from, const string &to)
+	{
+#ifdef _WIN32
+		return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		return rename(from.c_str(), to.c_str()) == 0;
+#endif
+	}
+}
+
+//////////////////////////////ThumbnailArchive//////////////////////////////
+
+ThumbnailArchive::ThumbnailArchive()
+{
+	close();
+}
+
+bool ThumbnailArchive::open(const string &path)
+{
+	close();
+	if (!file.open(path)) {
+		return false;
+	}
+
+	const char *base = file.data();
+	size_t length = file.size();
+	ArchiveHeader header;
+	if (length < sizeof(header)) {
+		cout << "[error: ThumbnailArchive.cpp] " << path << " is too small" << endl;
+		close();
+		return false;
+	}
+	memcpy(&header, base, sizeof(header));
+	if (memcmp(header.magic, archiveMagic, 4) != 0 || header.version != VERSION) {
+		cout << "[error: ThumbnailArchive.cpp] " << path << " is not a version " << VERSION << " thumbnail archive" << endl;
+		close();
+		return false;
+	}
+
+	uint64_t bytes = alignTile((uint64_t)header.tileWidth * header.tileHeight * 3);
+	uint64_t indexEnd = header.indexOffset + (uint64_t)header.entryCount * sizeof(ArchiveEntry);
+	if (indexEnd > length || header.namesOffset + header.namesLength > length ||
+		header.indexOffset % 4 != 0 || header.tileWidth > 0xFFFF || header.tileHeight > 0xFFFF) {
+		cout << "[error: ThumbnailArchive.cpp] " << path << " is truncated" << endl;
+		close();
+		return false;
+	}
+
+	entryCount = header.entryCount;
+	tileW = header.tileWidth;
+	tileH = header.tileHeight;
+	tileBytes = bytes;
+	index = base + header.indexOffset;
+	names = base + header.namesOffset;
+	namesLength = header.namesLength;
+	end = header.namesOffset + header.namesLength;
+
+	for (uint32_t e = 0; e < entryCount; ++e) {
+		const ArchiveEntry &entry = entryAt(index, e);
+		bool failed = entry.width == 0 && entry.height == 0;
+		uint64_t tileEnd = (uint64_t)entry.page * tileAlign + tileBytes;
+		if (entry.name >= namesLength || entry.width > tileW || entry.height > tileH ||
+			(!failed && (entry.width == 0 || entry.height == 0 || entry.page == 0 || tileEnd > length))) {
+			cout << "[error: ThumbnailArchive.cpp] " << path << " index is damaged" << endl;
+			close();
+			return false;
+		}
+	}
+	if (namesLength > 0 && names[namesLength - 1] != '\0') {
+		cout << "[error: ThumbnailArchive.cpp] " << path << " names are truncated" << endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void ThumbnailArchive::close()
+{
+	file.close();
+	entryCount = 0;
+	tileW = 0;
+	tileH = 0;
+	tileBytes = 0;
+	index = nullptr;
+	names = nullptr;
+	namesLength = 0;
+	end = 0;
+}
+
+bool ThumbnailArchive::isOpen() const
+{
+	return file.isOpen();
+}
+
+uint32_t ThumbnailArchive::size() const
+{
+	return entryCount;
+}
+
+int ThumbnailArchive::tileWidth() const
+{
+	return tileW;
+}
+
+int ThumbnailArchive::tileHeight() const
+{
+	return tileH;
+}
+
+int ThumbnailArchive::entry(const string &name) const
+{
+	int lo = 0;
+	int hi = (int)entryCount - 1;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		int c = strcmp(names + entryAt(index, mid).name, name.c_str());
+		if (c == 0) return mid;
+		if (c < 0) lo = mid + 1;
+		else hi = mid - 1;
+	}
+	return -1;
+}
+
+int ThumbnailArchive::find(const string &name) const
+{
+	int e = entry(name);
+	if (e < 0 || entryAt(index, e).width == 0) {
+		return -1;
+	}
+	return e;							//Tiles are numbered by index entry
+}
+
+bool ThumbnailArchive::contains(const string &name) const
+{
+	return entry(name) >= 0;
+}
+
+int ThumbnailArchive::width(uint32_t tile) const
+{
+	return entryAt(index, tile).width;
+}
+
+int ThumbnailArchive::height(uint32_t tile) const
+{
+	return entryAt(index, tile).height;
+}
+
+const unsigned char *ThumbnailArchive::pixels(uint32_t tile) const
+{
+	return (const unsigned char *)file.data() + (uint64_t)entryAt(index, tile).page * tileAlign;
+}
+
+///////////////////////////ThumbnailArchiveWriter///////////////////////////
+
+ThumbnailArchiveWriter::ThumbnailArchiveWriter()
+	: out(nullptr), appending(false), end(0), tileW(0), tileH(0), tileBytes(0)
+{
+}
+
+ThumbnailArchiveWriter::~ThumbnailArchiveWriter()
+{
+	abandon();
+}
+
+bool ThumbnailArchiveWriter::start(const string &path, int tileWidth, int tileHeight)
+{
+	abandon();
+	archivePath = path;
+	tileW = tileWidth;
+	tileH = tileHeight;
+	tileBytes = alignTile((uint64_t)tileW * tileH * 3);
+	entryNames.clear();
+	entryPages.clear();
+	entrySizes.clear();
+	return tileW > 0 && tileH > 0 && tileW <= 0xFFFF && tileH <= 0xFFFF;
+}
+
+void ThumbnailArchiveWriter::abandon()
+{
+	if (out == nullptr) {
+		return;
+	}
+	fclose(out);
+	out = nullptr;
+	if (!appending) {
+		remove((archivePath + ".tmp").c_str());
+	}
+}
+
+bool ThumbnailArchiveWriter::begin(const string &path, int tileWidth, int tileHeight)
+{
+	if (!start(path, tileWidth, tileHeight)) {
+		return false;
+	}
+	string tmpPath = path + ".tmp";
+	out = fopen(tmpPath.c_str(), "wb");
+	if (out == nullptr) {
+		cout << "[error: ThumbnailArchive.cpp] cannot write " << tmpPath << endl;
+		return false;
+	}
+	appending = false;
+	end = tileAlign;					//Header, tiles start on the next page
+	return true;
+}
+
+bool ThumbnailArchiveWriter::append(const string &path, int tileWidth, int tileHeight)
+{
+	if (!start(path, tileWidth, tileHeight)) {
+		return false;
+	}
+	ThumbnailArchive archive;
+	if (!archive.open(path)) {
+		return false;
+	}
+	if (archive.tileWidth() != tileW || archive.tileHeight() != tileH) {
+		cout << " [!] " << path << " has " << archive.tileWidth() << "x" << archive.tileHeight() << " tiles, not appended to" << endl;
+		return false;
+	}
+	for (uint32_t e = 0; e < archive.size(); ++e) {
+		const ArchiveEntry &entry = entryAt(archive.index, e);
+		entryNames.push_back(archive.names + entry.name);
+		entryPages.push_back(entry.page);
+		entrySizes.push_back(make_pair(entry.width, entry.height));
+	}
+	end = alignTile(archive.end);		//Old index and names stay, the open archive still reads them
+	archive.close();
+
+	out = fopen(path.c_str(), "r+b");
+	if (out == nullptr) {
+		cout << "[error: ThumbnailArchive.cpp] cannot write " << path << endl;
+		return false;
+	}
+	appending = true;
+	return true;
+}
+
+bool ThumbnailArchiveWriter::add(const string &name, int width, int height, const unsigned char *rgb)
+{
+	if (out == nullptr || width <= 0 || height <= 0 || width > tileW || height > tileH || end / tileAlign > 0xFFFFFFFF) {
+		return false;
+	}
+	size_t bytes = (size_t)width * height * 3;
+	if (!seekTo(out, end) || fwrite(rgb, 1, bytes, out) != bytes) {
+		return false;
+	}
+	entryNames.push_back(name);
+	entryPages.push_back((uint32_t)(end / tileAlign));
+	entrySizes.push_back(make_pair((uint16_t)width, (uint16_t)height));
+	end += tileBytes;
+	return true;
+}
+
+void ThumbnailArchiveWriter::addFailed(const string &name)
+{
+	entryNames.push_back(name);
+	entryPages.push_back(0);
+	entrySizes.push_back(make_pair((uint16_t)0, (uint16_t)0));
+}
+
+uint32_t ThumbnailArchiveWriter::size() const
+{
+	return (uint32_t)entryNames.size();
+}
+
+bool ThumbnailArchiveWriter::commit()
+{
+	if (out == nullptr) {
+		return false;
+	}
+	uint32_t count = size();
+
+	//Index sorted by name for binary search, duplicate names keep the first entry
+	vector<uint32_t> order(count);
+	for (uint32_t t = 0; t < count; ++t) {
+		order[t] = t;
+	}
+	stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return entryNames[a] < entryNames[b]; });
+
+	vector<ArchiveEntry> index;
+	string names;
+	for (uint32_t e = 0; e < count; ++e) {
+		uint32_t t = order[e];
+		if (e > 0 && entryNames[t] == entryNames[order[e - 1]]) {
+			continue;
+		}
+		ArchiveEntry entry;
+		entry.name = (uint32_t)names.size();
+		entry.page = entryPages[t];
+		entry.width = entrySizes[t].first;
+		entry.height = entrySizes[t].second;
+		index.push_back(entry);
+		names += entryNames[t];
+		names += '\0';
+	}
+
+	ArchiveHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, archiveMagic, 4);
+	header.version = ThumbnailArchive::VERSION;
+	header.entryCount = (uint32_t)index.size();
+	header.tileWidth = tileW;
+	header.tileHeight = tileH;
+	header.indexOffset = end;			//Page aligned
+	header.namesOffset = header.indexOffset + (uint64_t)index.size() * sizeof(ArchiveEntry);
+	header.namesLength = names.size();
+
+	//Tiles and index on disk before the header points to them
+	bool written = seekTo(out, header.indexOffset) &&
+		(index.empty() || fwrite(&index[0], sizeof(ArchiveEntry), index.size(), out) == index.size()) &&
+		fwrite(names.data(), 1, names.size(), out) == names.size() && syncFile(out) &&
+		seekTo(out, 0) && fwrite(&header, sizeof(header), 1, out) == 1 && syncFile(out);
+	fclose(out);
+	out = nullptr;
+
+	if (appending) {
+		if (!written) {
+			cout << "[error: ThumbnailArchive.cpp] cannot append to " << archivePath << endl;
+		}
+		return written;
+	}
+	string tmpPath = archivePath + ".tmp";
+	if (!written || !replaceFile(tmpPath, archivePath)) {
+		cout << "[error: ThumbnailArchive.cpp] cannot commit " << archivePath << endl;
+		remove(tmpPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+//////////////////////////ThumbnailArchiveAppender//////////////////////////
+
+ThumbnailArchiveAppender::ThumbnailArchiveAppender() : stopping(false)
+{
+}
+
+ThumbnailArchiveAppender::~ThumbnailArchiveAppender()
+{
+	stop();
+}
+
+void ThumbnailArchiveAppender::start(const string &archivePath, int tileWidth, int tileHeight, bool rebuild,
+	const vector<string> &names, const vector<string> &paths, Decode decode)
+{
+	if (thread.joinable()) {
+		cout << "[error: ThumbnailArchive.cpp] thumbnails already being appended" << endl;
+		return;
+	}
+	stopping = false;
+	thread = std::thread(&ThumbnailArchiveAppender::run, this, archivePath, tileWidth, tileHeight, rebuild, names, paths, decode);
+}
+
+void ThumbnailArchiveAppender::stop()
+{
+	stopping = true;
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+void ThumbnailArchiveAppender::run(string archivePath, int tileWidth, int tileHeight, bool rebuild,
+	vector<string> names, vector<string> paths, Decode decode)
+{
+	ThumbnailArchiveWriter writer;
+	if (rebuild ? !writer.begin(archivePath, tileWidth, tileHeight) : !writer.append(archivePath, tileWidth, tileHeight)) {
+		return;
+	}
+
+	size_t added = 0;
+	size_t failed = 0;
+	vector<unsigned char> rgb;
+	for (size_t i = 0; i < names.size() && !stopping; ++i) {
+		int width = 0;
+		int height = 0;
+		if (!decode(paths[i], rgb, width, height)) {
+			writer.addFailed(names[i]);
+			failed++;
+		}
+		else if (writer.add(names[i], width, height, rgb.data())) {
+			added++;
+		}
+		else {
+			cout << "[error: ThumbnailArchive.cpp] cannot write thumbnail of " << names[i] << endl;
+			break;
+		}
+	}
+	if (added + failed > 0 && writer.commit()) {
+		cout << " [*] thumbnail archive: " << added << " thumbnails added";
+		if (failed > 0)
+			cout << ", " << failed << " not readable";
+		cout << endl;
+	}
+}
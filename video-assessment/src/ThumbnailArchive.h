@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MappedFile.h"
+
+//All video thumbnails in one file, decoded, so loading them is reading a
+//mapping instead of opening and decoding a jpg per clip.
+//
+//Layout (little endian):
+//  header | tiles | index | names [| tiles | index | names ...]
+//A tile is RGB rows of the thumbnail width, in a fixed size block of
+//tileWidth x tileHeight x 3 bytes rounded to 4 KB. The index has one entry per
+//name sorted by name, with the page of its tile; names are nul terminated.
+//Appends write new tiles and a whole new index after the old names, then the
+//header, so an open archive never sees its mapped bytes change. An entry
+//without a tile (0 x 0) is a thumbnail that could not be decoded.
+//Layout changes bump VERSION.
+class ThumbnailArchive
+{
+public:
+	static const uint32_t VERSION = 2;
+
+	ThumbnailArchive();
+
+	bool open(const std::string &path);		//Map and validate archive
+	void close();
+	bool isOpen() const;
+
+	uint32_t size() const;					//Number of entries, failed ones included
+	int tileWidth() const;
+	int tileHeight() const;
+	int find(const std::string &name) const;	//Binary search in index, tile or -1
+	bool contains(const std::string &name) const;	//Has a tile or failed to decode before
+
+	int width(uint32_t tile) const;
+	int height(uint32_t tile) const;
+	const unsigned char *pixels(uint32_t tile) const;	//width x height RGB, in the mapping
+
+private:
+	friend class ThumbnailArchiveWriter;
+
+	ThumbnailArchive(const ThumbnailArchive &);
+	ThumbnailArchive &operator=(const ThumbnailArchive &);
+
+	int entry(const std::string &name) const;	//Index entry or -1
+
+	MappedFile file;
+	uint32_t entryCount;
+	int tileW;
+	int tileH;
+	uint64_t tileBytes;
+	const char *index;						//entryCount entries sorted by name
+	const char *names;
+	uint64_t namesLength;
+	uint64_t end;							//End of the names, appends go after it
+};
+
+//Write side. begin() streams a new archive to path + ".tmp" and commit()
+//renames it over path; append() adds to an existing archive in place and
+//commit() writes its header last, so an interrupted append leaves the old one.
+class ThumbnailArchiveWriter
+{
+public:
+	ThumbnailArchiveWriter();
+	~ThumbnailArchiveWriter();					//Drops what is not committed
+
+	bool begin(const std::string &path, int tileWidth, int tileHeight);
+	bool append(const std::string &path, int tileWidth, int tileHeight);	//False if missing, damaged or another tile size
+	bool add(const std::string &name, int width, int height, const unsigned char *rgb);	//At most tile size
+	void addFailed(const std::string &name);	//Listed without a tile, not decoded again
+	bool commit();
+	uint32_t size() const;						//Entries, the appended archive's included
+
+private:
+	ThumbnailArchiveWriter(const ThumbnailArchiveWriter &);
+	ThumbnailArchiveWriter &operator=(const ThumbnailArchiveWriter &);
+
+	bool start(const std::string &path, int tileWidth, int tileHeight);
+	void abandon();
+
+	std::string archivePath;
+	FILE *out;
+	bool appending;
+	uint64_t end;								//Where the next tile goes
+	int tileW;
+	int tileH;
+	uint64_t tileBytes;
+	std::vector<std::string> entryNames;
+	std::vector<uint32_t> entryPages;
+	std::vector<std::pair<uint16_t, uint16_t> > entrySizes;
+};
+
+//Adds the thumbnails an archive is missing on its own thread, so the gallery
+//starts with the tiles already there and never waits for the jpgs. decode
+//reads one thumbnail as RGB, false when it can't be read; those are listed as
+//failed so the next start doesn't try them again. What was added is used from
+//the next time the archive is opened.
+class ThumbnailArchiveAppender
+{
+public:
+	typedef std::function<bool(const std::string &path, std::vector<unsigned char> &rgb, int &width, int &height)> Decode;
+
+	ThumbnailArchiveAppender();
+	~ThumbnailArchiveAppender();				//Stops, see stop()
+
+	//Appends to the archive at archivePath, or writes a new one over it if rebuild
+	void start(const std::string &archivePath, int tileWidth, int tileHeight, bool rebuild,
+		const std::vector<std::string> &names, const std::vector<std::string> &paths, Decode decode);
+	void stop();								//Waits for the thumbnail being decoded, commits the ones done
+
+private:
+	ThumbnailArchiveAppender(const ThumbnailArchiveAppender &);
+	ThumbnailArchiveAppender &operator=(const ThumbnailArchiveAppender &);
+
+	void run(std::string archivePath, int tileWidth, int tileHeight, bool rebuild,
+		std::vector<std::string> names, std::vector<std::string> paths, Decode decode);
+
+	std::thread thread;
+	std::atomic<bool> stopping;
+};
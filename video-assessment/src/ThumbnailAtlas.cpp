@@ -0,0 +1,139 @@
+#include "ThumbnailAtlas.h"
+
+namespace {
+	const int padding = 1;						//Between slots, no bleeding of neighbours when filtered
+}
+
+ThumbnailAtlas::ThumbnailAtlas() : cellWidth(0), cellHeight(0)
+{
+}
+
+void ThumbnailAtlas::allocate(int slotWidth, int slotHeight, size_t count)
+{
+	pages.clear();
+	slots.clear();
+	cellWidth = min(max(1, slotWidth), pageSize);
+	cellHeight = min(max(1, slotHeight), pageSize);
+
+	int columns = (pageSize + padding) / (cellWidth + padding);
+	int rows = (pageSize + padding) / (cellHeight + padding);
+	size_t perPage = (size_t)columns * rows;
+	for (size_t s = 0; s < count; ++s) {
+		if (s % perPage == 0) {
+			pages.push_back(Page());
+			pages.back().texture.allocate(pageSize, pageSize, GL_RGB);
+			pages.back().mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+		}
+		int cell = s % perPage;
+		Slot slot;
+		slot.page = pages.size() - 1;
+		slot.x = (cell % columns) * (cellWidth + padding);
+		slot.y = (cell / columns) * (cellHeight + padding);
+		slot.width = 0;
+		slot.height = 0;
+		slots.push_back(slot);
+	}
+}
+
+size_t ThumbnailAtlas::size() const
+{
+	return slots.size();
+}
+
+int ThumbnailAtlas::slotWidth() const
+{
+	return cellWidth;
+}
+
+int ThumbnailAtlas::slotHeight() const
+{
+	return cellHeight;
+}
+
+bool ThumbnailAtlas::upload(int slot, const ofPixels &thumbnail)
+{
+	if (thumbnail.getNumChannels() != 3) {
+		return false;
+	}
+	return upload(slot, thumbnail.getData(), thumbnail.getWidth(), thumbnail.getHeight());
+}
+
+bool ThumbnailAtlas::upload(int slot, const unsigned char *rgb, int w, int h)
+{
+	if (slot < 0 || slot >= (int)slots.size() || w <= 0 || h <= 0 || w > cellWidth || h > cellHeight) {
+		return false;
+	}
+	Slot &s = slots[slot];
+	const ofTextureData &data = pages[s.page].texture.getTextureData();
+
+	//Only the slot is sent, ofTexture::loadData would send the whole page
+	glBindTexture(data.textureTarget, data.textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(data.textureTarget, 0, s.x, s.y, w, h, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(data.textureTarget, 0);
+
+	s.width = w;
+	s.height = h;
+	return true;
+}
+
+int ThumbnailAtlas::width(int slot) const
+{
+	return slots[slot].width;
+}
+
+int ThumbnailAtlas::height(int slot) const
+{
+	return slots[slot].height;
+}
+
+void ThumbnailAtlas::begin()
+{
+	for (Page &page : pages) {
+		page.mesh.clear();
+	}
+}
+
+void ThumbnailAtlas::addQuad(int slot, float x, float y, float clipTop, float clipBottom)
+{
+	if (slot < 0 || slot >= (int)slots.size()) {
+		return;
+	}
+	const Slot &s = slots[slot];
+	float top = max(y, clipTop);
+	float bottom = min(y + s.height, clipBottom);
+	if (bottom <= top) {
+		return;
+	}
+
+	Page &page = pages[s.page];
+	ofPoint t0 = page.texture.getCoordFromPoint(s.x, s.y + (top - y));		//Pixel or normalized coordinates, as the texture needs
+	ofPoint t1 = page.texture.getCoordFromPoint(s.x + s.width, s.y + (bottom - y));
+
+	ofMesh &mesh = page.mesh;
+	mesh.addVertex(ofVec3f(x, top, 0));
+	mesh.addVertex(ofVec3f(x + s.width, top, 0));
+	mesh.addVertex(ofVec3f(x + s.width, bottom, 0));
+	mesh.addVertex(ofVec3f(x, top, 0));
+	mesh.addVertex(ofVec3f(x + s.width, bottom, 0));
+	mesh.addVertex(ofVec3f(x, bottom, 0));
+	mesh.addTexCoord(ofVec2f(t0.x, t0.y));
+	mesh.addTexCoord(ofVec2f(t1.x, t0.y));
+	mesh.addTexCoord(ofVec2f(t1.x, t1.y));
+	mesh.addTexCoord(ofVec2f(t0.x, t0.y));
+	mesh.addTexCoord(ofVec2f(t1.x, t1.y));
+	mesh.addTexCoord(ofVec2f(t0.x, t1.y));
+}
+
+void ThumbnailAtlas::draw()
+{
+	for (Page &page : pages) {
+		if (page.mesh.getNumVertices() == 0) {
+			continue;
+		}
+		page.texture.bind();
+		page.mesh.draw();
+		page.texture.unbind();
+	}
+}
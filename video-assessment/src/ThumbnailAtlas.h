@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ofMain.h"
+
+//Slots of thumbnail size in a few large textures (pages). A thumbnail is
+//uploaded into a slot as a subimage, and a slot can be reused for another one.
+//A frame queues the thumbnails in view as quads, clipped through their texture
+//coordinates, and draws one mesh per page.
+class ThumbnailAtlas
+{
+public:
+	ThumbnailAtlas();
+
+	void allocate(int slotWidth, int slotHeight, size_t slots);	//GL thread
+	size_t size() const;
+	int slotWidth() const;
+	int slotHeight() const;
+	bool upload(int slot, const ofPixels &thumbnail);	//RGB, at most slot size. GL thread
+	bool upload(int slot, const unsigned char *rgb, int width, int height);	//Rows of width x 3 bytes
+	int width(int slot) const;					//Of the thumbnail in the slot
+	int height(int slot) const;
+
+	void begin();								//Forget the quads of the last frame
+	void addQuad(int slot, float x, float y, float clipTop, float clipBottom);	//Top left at x, y, rows outside [clipTop, clipBottom] cut
+	void draw();								//One batched draw per page with quads
+
+	static const int pageSize = 2048;
+
+private:
+	struct Page
+	{
+		ofTexture texture;
+		ofMesh mesh;
+	};
+
+	struct Slot
+	{
+		int page;
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	int cellWidth;
+	int cellHeight;
+	vector<Page> pages;
+	vector<Slot> slots;
+};
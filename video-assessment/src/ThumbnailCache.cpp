@@ -0,0 +1,235 @@
+#include "ThumbnailCache.h"
+
+ThumbnailCache::ThumbnailCache(int slotWidth, int slotHeight, size_t capacity, unsigned threads)
+	: frame(1), archive(nullptr), tasks(0), generation(0), stopping(false), pool(threads)
+{
+	slots.allocate(slotWidth, slotHeight, capacity);
+	slotFile.assign(slots.size(), -1);
+	slotFrame.assign(slots.size(), 0);
+	recentPosition.resize(slots.size());
+	for (size_t s = 0; s < slots.size(); ++s) {
+		recentPosition[s] = recent.insert(recent.end(), (int)s);
+	}
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+	{
+		lock_guard<mutex> lock(stateMutex);
+		stopping = true;
+		pending.clear();						//Queued tasks find nothing to do
+	}
+	pool.wait();
+}
+
+void ThumbnailCache::setFiles(const vector<string> &paths, const ThumbnailArchive *archive, const vector<int> &tiles)
+{
+	{
+		lock_guard<mutex> lock(stateMutex);
+		pending.clear();
+	}
+	pool.wait();								//No worker reads the old archive any more
+	{
+		lock_guard<mutex> lock(stateMutex);
+		this->paths = paths;
+		this->archive = archive;
+		this->tiles = tiles;
+		this->tiles.resize(paths.size(), -1);
+		state.assign(paths.size(), NONE);
+		pending.clear();
+		decoded.clear();
+		generation++;
+	}
+	fileSlot.assign(paths.size(), -1);
+	slotFile.assign(slots.size(), -1);
+	slotFrame.assign(slots.size(), 0);
+}
+
+void ThumbnailCache::addFiles(const vector<string> &paths)
+{
+	size_t count;
+	{
+		lock_guard<mutex> lock(stateMutex);
+		this->paths.insert(this->paths.end(), paths.begin(), paths.end());
+		count = this->paths.size();
+		tiles.resize(count, -1);
+		state.resize(count, NONE);
+	}
+	fileSlot.resize(count, -1);
+}
+
+void ThumbnailCache::request(const vector<int> &files)
+{
+	size_t count = min(files.size(), slots.size());	//More would evict each other
+	for (size_t k = count; k-- > 0;) {			//Resident ones are kept, first file most recent
+		int file = files[k];
+		if (file >= 0 && file < (int)fileSlot.size() && fileSlot[file] >= 0) {
+			touch(fileSlot[file]);
+		}
+	}
+
+	size_t newTasks = 0;
+	{
+		lock_guard<mutex> lock(stateMutex);
+		for (int file : pending) {
+			state[file] = NONE;
+		}
+		pending.clear();
+		for (size_t k = 0; k < count; ++k) {
+			int file = files[k];
+			if (file >= 0 && file < (int)state.size() && state[file] == NONE && fileSlot[file] < 0) {
+				state[file] = QUEUED;
+				pending.push_back(file);
+			}
+		}
+		if (pending.size() > tasks) {
+			newTasks = pending.size() - tasks;
+			tasks = pending.size();
+		}
+	}
+	for (size_t t = 0; t < newTasks; ++t) {
+		pool.enqueue([this] { decodeNext(); });
+	}
+}
+
+void ThumbnailCache::decodeNext()
+{
+	int file;
+	int tile;
+	string path;
+	unsigned fileGeneration;
+	{
+		lock_guard<mutex> lock(stateMutex);
+		tasks--;
+		if (stopping || pending.empty()) {
+			return;
+		}
+		file = pending.front();
+		pending.pop_front();
+		state[file] = DECODING;
+		path = paths[file];
+		tile = archive != nullptr ? tiles[file] : -1;
+		fileGeneration = generation;
+	}
+
+	ofPixels pixels;
+	bool loaded;
+	if (tile >= 0) {
+		//Read the tile in here, so the upload doesn't wait for the disk
+		const unsigned char *data = archive->pixels(tile);
+		size_t bytes = (size_t)archive->width(tile) * archive->height(tile) * 3;
+		unsigned sum = 0;
+		for (size_t b = 0; b < bytes; b += 4096) {
+			sum += data[b];
+		}
+		volatile unsigned touched = sum;
+		(void)touched;
+		loaded = true;
+	}
+	else {
+		loaded = decode(path, slots.slotWidth(), slots.slotHeight(), pixels);
+	}
+
+	lock_guard<mutex> lock(stateMutex);
+	if (fileGeneration != generation) {
+		return;
+	}
+	if (loaded) {
+		state[file] = DECODED;
+		Decoded d;
+		d.file = file;
+		d.tile = tile;
+		d.pixels = pixels;
+		decoded.push_back(d);
+	}
+	else {
+		state[file] = FAILED;					//Placeholder for good
+	}
+}
+
+void ThumbnailCache::update()
+{
+	frame++;
+	vector<Decoded> ready;
+	{
+		lock_guard<mutex> lock(stateMutex);
+		if (decoded.empty()) {
+			return;
+		}
+		size_t count = min(decoded.size(), (size_t)uploadsPerFrame);
+		ready.assign(decoded.begin(), decoded.begin() + count);
+		decoded.erase(decoded.begin(), decoded.begin() + count);
+	}
+
+	vector<int> dropped;
+	for (Decoded &r : ready) {
+		int file = r.file;
+		int s = recent.back();					//Free slots are kept at the back too
+		if (slotFrame[s] + 1 >= frame && slotFile[s] >= 0) {
+			dropped.push_back(file);			//Every slot was used by the last frame
+			continue;
+		}
+		bool uploaded = r.tile >= 0 ? slots.upload(s, archive->pixels(r.tile), archive->width(r.tile), archive->height(r.tile)) : slots.upload(s, r.pixels);
+		if (!uploaded) {
+			dropped.push_back(file);
+			continue;
+		}
+		if (slotFile[s] >= 0) {
+			fileSlot[slotFile[s]] = -1;			//Evicted, decoded again if requested again
+			dropped.push_back(slotFile[s]);
+		}
+		slotFile[s] = file;
+		fileSlot[file] = s;
+		touch(s);
+	}
+
+	lock_guard<mutex> lock(stateMutex);
+	for (int file : dropped) {
+		if (state[file] == DECODED) {
+			state[file] = NONE;
+		}
+	}
+}
+
+int ThumbnailCache::slot(int file)
+{
+	if (file < 0 || file >= (int)fileSlot.size() || fileSlot[file] < 0) {
+		return -1;
+	}
+	touch(fileSlot[file]);
+	return fileSlot[file];
+}
+
+bool ThumbnailCache::decode(const string &path, int maxWidth, int maxHeight, ofPixels &pixels)
+{
+	if (!ofLoadImage(pixels, path)) {
+		cout << " [!] thumbnail not loaded: " << path << endl;
+		return false;
+	}
+	if (pixels.getNumChannels() != 3) {
+		pixels.setImageType(OF_IMAGE_COLOR);
+	}
+	int w = pixels.getWidth();
+	int h = pixels.getHeight();
+	if (w > maxWidth || h > maxHeight) {		//Bigger than extracted thumbnails, fit it
+		double scale = min((double)maxWidth / w, (double)maxHeight / h);
+		pixels.resize(max(1, (int)(w * scale)), max(1, (int)(h * scale)));
+	}
+	return true;
+}
+
+ThumbnailAtlas &ThumbnailCache::atlas()
+{
+	return slots;
+}
+
+size_t ThumbnailCache::capacity() const
+{
+	return slots.size();
+}
+
+void ThumbnailCache::touch(int slot)
+{
+	recent.splice(recent.begin(), recent, recentPosition[slot]);
+	slotFrame[slot] = frame;
+}
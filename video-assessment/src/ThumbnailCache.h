@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ThumbnailArchive.h"
+#include "ThumbnailAtlas.h"
+#include "ThreadPool.h"
+
+#include <list>
+#include <mutex>
+
+//Gallery thumbnails decoded on background threads and kept in a bounded set of
+//atlas slots. Every frame the gallery asks for the files it shows (and will
+//show soon), most wanted first; files that fell out of the request before a
+//worker took them are not decoded. Decoded thumbnails are uploaded on the GL
+//thread, into a free slot or the least recently used one. Files in the
+//thumbnail archive are not decoded: the worker only reads their tile in, and
+//the tile is uploaded from the mapping.
+class ThumbnailCache
+{
+public:
+	ThumbnailCache(int slotWidth, int slotHeight, size_t capacity, unsigned threads = 2);	//GL thread
+	~ThumbnailCache();							//Waits for the thumbnails being decoded
+
+	//Thumbnail path and archive tile (-1 = not archived) per file. Drops all thumbnails,
+	//archive must stay open until the next setFiles
+	void setFiles(const vector<string> &paths, const ThumbnailArchive *archive = nullptr, const vector<int> &tiles = vector<int>());
+	void addFiles(const vector<string> &paths);	//Appended after the others, not archived. Keeps the thumbnails
+	void request(const vector<int> &files);		//Replaces the last request, at most capacity() files are kept
+	void update();								//Upload decoded thumbnails, GL thread
+	int slot(int file);							//Atlas slot of the file, -1 while not decoded. Marks it used
+	ThumbnailAtlas &atlas();
+	size_t capacity() const;
+
+	static bool decode(const string &path, int maxWidth, int maxHeight, ofPixels &pixels);	//RGB, scaled down to fit. Any thread
+
+	static const int uploadsPerFrame = 32;		//The rest waits for the next frame
+
+private:
+	ThumbnailCache(const ThumbnailCache &);
+	ThumbnailCache &operator=(const ThumbnailCache &);
+
+	enum State { NONE, QUEUED, DECODING, DECODED, FAILED };
+
+	struct Decoded
+	{
+		int file;
+		int tile;								//Archive tile, pixels unused
+		ofPixels pixels;
+	};
+
+	void decodeNext();							//Worker task, one file from the request
+	void touch(int slot);
+
+	ThumbnailAtlas slots;
+
+	//GL thread only
+	vector<int> fileSlot;						//-1 = not in the atlas
+	vector<int> slotFile;						//-1 = free
+	vector<unsigned> slotFrame;					//Frame of the last use
+	list<int> recent;							//Slots, most recently used first
+	vector<list<int>::iterator> recentPosition;
+	unsigned frame;
+
+	//Shared with the workers
+	mutex stateMutex;
+	vector<string> paths;
+	const ThumbnailArchive *archive;
+	vector<int> tiles;
+	vector<unsigned char> state;				//State by file
+	deque<int> pending;							//Requested files not taken by a worker yet
+	vector<Decoded> decoded;					//Waiting for upload
+	size_t tasks;								//Queued decodeNext calls
+	unsigned generation;						//setFiles count, results of older files are dropped
+	bool stopping;
+
+	ThreadPool pool;							//Last, stopped first
+};
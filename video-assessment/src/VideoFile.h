@@ -6,11 +6,9 @@ class VideoFile :
 {
 public:
 	VideoFile();
-	VideoFile(const File *f);
 	VideoFile(string name, string path);
 	~VideoFile();
 
-	ofVideoPlayer video;							//Image
 	static string filesFolderPath;					//Path to files
 	static string thumbnailFolderPath;				//Path to thumbnails
 	static string thumbnailIconPath;				//Path to camera icon to add to thumbnail
@@ -43,16 +41,18 @@ public:
 	//virtual void draw() override;
 	//string generateThumbnail() override;
 	bool generateXmlFile() override;
-	bool getMetadataFromXml()  override;
-	bool getMetadataFromCsv(vector<string> csvData) override; // csv parse
+	bool getMetadataFromFeatures(int id, const FeatureRecord &features) override;
+	bool getMetadataFromStore(const FeatureStore &store, int row) override;
+	void writeToStore(FeatureStoreWriter &writer, uint32_t row) override;
 	void getMetadataFromSemanticSample(vector< pair <double, int > > semanticSample); // csv parse semantic
 	void getMetadataFromAudioSample(vector< double > audioSample); // csv parse audio
 
 	void setThumbnailPath() override;
 	bool loadThumbnail() override;
-	void draw(ofRectangle space, bool play, ofTrueTypeFont *playerText);
 	void draw(int x, int y, bool play);
-	void stopVideo();
+
+protected:
+	void getMetadataFromXmlFields(const XmlFieldReader &xml) override;
 
 private:
 
@@ -0,0 +1,149 @@
+#include "XmlFieldReader.h"
+#include "MappedFile.h"
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+	//Replace the five predefined entities, the only ones ofXml writes
+	string unescape(const char *begin, const char *end)
+	{
+		string out;
+		out.reserve(end - begin);
+		for (const char *p = begin; p < end; ++p) {
+			if (*p != '&') {
+				out += *p;
+				continue;
+			}
+			const char *semi = (const char *)memchr(p, ';', end - p);
+			if (semi == nullptr) {
+				out += *p;
+				continue;
+			}
+			string entity(p + 1, semi);
+			if (entity == "amp") out += '&';
+			else if (entity == "lt") out += '<';
+			else if (entity == "gt") out += '>';
+			else if (entity == "quot") out += '"';
+			else if (entity == "apos") out += '\'';
+			else {
+				out.append(p, semi + 1);
+			}
+			p = semi;
+		}
+		return out;
+	}
+
+	const char *findComment(const char *p, const char *end)
+	{
+		for (; p + 3 <= end; ++p) {
+			if (p[0] == '-' && p[1] == '-' && p[2] == '>') return p + 2;
+		}
+		return nullptr;
+	}
+
+	bool isNameEnd(char c)
+	{
+		return c == '>' || c == '/' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+}
+
+bool XmlFieldReader::load(const string &path)
+{
+	clear();
+	MappedFile file;
+	if (!file.open(path)) {
+		return false;
+	}
+	return parse(file.data(), file.size());
+}
+
+bool XmlFieldReader::parse(const char *text, size_t length)
+{
+	const char *p = text;
+	const char *end = text + length;
+
+	//Name and text start of the innermost open element, and whether it had children
+	const char *openName = nullptr;
+	size_t openLength = 0;
+	const char *textStart = nullptr;
+	bool hasChild = false;
+
+	while (p < end) {
+		const char *lt = (const char *)memchr(p, '<', end - p);
+		if (lt == nullptr || lt + 1 >= end) {
+			break;
+		}
+
+		if (lt[1] == '?' || lt[1] == '!') {		//Declaration or comment
+			const char *close = (lt[1] == '!' && end - lt > 3 && lt[2] == '-' && lt[3] == '-') ?
+				findComment(lt + 4, end) : (const char *)memchr(lt, '>', end - lt);
+			if (close == nullptr) return false;
+			p = close + 1;
+			continue;
+		}
+
+		const char *gt = (const char *)memchr(lt, '>', end - lt);
+		if (gt == nullptr) {
+			return false;
+		}
+
+		if (lt[1] == '/') {						//Closing tag
+			const char *name = lt + 2;
+			size_t nameLength = gt - name;
+			if (!hasChild && openName != nullptr && nameLength == openLength && memcmp(name, openName, nameLength) == 0) {
+				fields.emplace(string(name, nameLength), unescape(textStart, lt));
+			}
+			openName = nullptr;
+			hasChild = true;					//Parent of this element is not a leaf
+		}
+		else {									//Opening or empty tag
+			const char *name = lt + 1;
+			const char *nameEnd = name;
+			while (nameEnd < gt && !isNameEnd(*nameEnd)) nameEnd++;
+			if (gt[-1] == '/') {				//<NAME/>, empty value
+				fields.emplace(string(name, nameEnd - name), string());
+				hasChild = true;
+			}
+			else {
+				openName = name;
+				openLength = nameEnd - name;
+				textStart = gt + 1;
+				hasChild = false;
+			}
+		}
+		p = gt + 1;
+	}
+	return !fields.empty();
+}
+
+void XmlFieldReader::clear()
+{
+	fields.clear();
+}
+
+bool XmlFieldReader::has(const string &name) const
+{
+	return fields.find(name) != fields.end();
+}
+
+int XmlFieldReader::getInt(const string &name) const
+{
+	unordered_map<string, string>::const_iterator it = fields.find(name);
+	return it == fields.end() ? 0 : atoi(it->second.c_str());
+}
+
+double XmlFieldReader::getDouble(const string &name) const
+{
+	unordered_map<string, string>::const_iterator it = fields.find(name);
+	return it == fields.end() ? 0 : strtod(it->second.c_str(), nullptr);
+}
+
+string XmlFieldReader::getString(const string &name) const
+{
+	unordered_map<string, string>::const_iterator it = fields.find(name);
+	return it == fields.end() ? string() : it->second;
+}
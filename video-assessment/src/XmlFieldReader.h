@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+//Single pass reader for the flat metadata xml files. Walks the file once and
+//keeps the text of every leaf element by tag name, so a field lookup is a hash
+//find instead of an XPath query over the DOM. Like "//NAME", the first element
+//with a given name wins.
+class XmlFieldReader
+{
+public:
+	bool load(const std::string &path);		//Read and index file, false if missing or malformed
+	bool parse(const char *text, size_t length);
+	void clear();
+
+	bool has(const std::string &name) const;
+	int getInt(const std::string &name) const;			//0 if missing, like ofXml::getValue
+	double getDouble(const std::string &name) const;
+	std::string getString(const std::string &name) const;
+
+private:
+	std::unordered_map<std::string, std::string> fields;
+};
@@ -4,6 +4,7 @@
 
 #include "extractor.h"
 #include "RunningStats.h"
+#include "XmlFieldReader.h"
 #include <chrono>
 
 using namespace std;
@@ -34,6 +35,7 @@ bool hsv = true;
 bool focus = true;
 bool bgSub = true;
 bool colorfullness = true;
+bool predictOnly = false;		//Only the steps the SVM inputs need, see applyModelStages
 
 //bg subtraction parameters
 
@@ -68,6 +70,19 @@ vector< pair<double, int> >  semanticMap;
 
 vector<double> audioMap;
 
+//audio analysis tools, found through the PATH
+#ifdef _WIN32
+const string ffmpegCommand = "ffmpeg.exe";
+const string musicExtractorCommand = "streaming_extractor_music.exe";
+const string nullDevice = "nul:";
+#else
+const string ffmpegCommand = "ffmpeg";
+const string musicExtractorCommand = "streaming_extractor_music";
+const string nullDevice = "/dev/null";
+#endif
+const string audioTrackPath = "data/audio/outputFile.mp4";
+const string audioFeaturesPath = "data/audio/extractor_music_output.json";
+
 String modelTxt = "data/dnn/bvlc_googlenet.prototxt";
 String modelBin = "data/dnn/bvlc_googlenet.caffemodel";
 Net net;
@@ -75,9 +90,7 @@ Net net;
 processing pp;                   //processing class object
 utility uu;                      //utility class object
 
-json jAestheticSample = {};
-json jInterestSample = {};
-json jsonAll = {};
+FeatureRecord features;          //features of the last extracted video
 
 //color ratios
 double redRatio, greenRatio, blueRatio;
@@ -314,6 +327,9 @@ vector <double > extractor::getAudioMap() {
 void extractor::extractFromVideo(string filePath, int nv) {
 
 	getConfigParams();
+	if (predictOnly) {
+		applyModelStages();
+	}
 
 	static_saliency_algorithm = "SPECTRAL_RESIDUAL";
 	//instantiates the specific static Saliency
@@ -362,6 +378,7 @@ void extractor::extractFromVideo(string filePath, int nv) {
 
 	if (nv == 1) {
 
+		cout << " [*] Predict only:" << predictOnly << endl;
 		cout << " [*] Sampling factor:" << samplingFactor << endl;
 		cout << " [*] Resize:" << resizeMode << endl;
 		cout << " [*] Background subtraction:" << bgSub << endl;
@@ -442,7 +459,7 @@ void extractor::extractFromVideo(string filePath, int nv) {
 
 			if (!onceTwice && frameCount >= length / 5) { //creating thumbnails at 1/5th of video duration
 
-				size_t lastindex1 = filePath.find_last_of("\\");
+				size_t lastindex1 = filePath.find_last_of("/\\");		//glob gives '/' on Linux
 				name = filePath.substr(lastindex1);
 				size_t lastindex2 = name.find_last_of(".");
 				name = name.substr(0, lastindex2);
@@ -786,16 +803,16 @@ void extractor::extractFromVideo(string filePath, int nv) {
 			const char *result = "";
 			const char *inputFile = filePath.c_str();
 			std::string str;
-			str = "ffmpeg.exe -y -nostats -loglevel 0 -i ";
+			str = ffmpegCommand + " -y -nostats -loglevel 0 -i ";
 			str += inputFile;
-			str += " -vn -acodec copy data\\audio\\outputFile.mp4";
+			str += " -vn -acodec copy " + audioTrackPath;
 			result = str.c_str();
 
 			int status = system(result);
 
 			int fileSize = 0.0;
 			streampos begin, end;
-			ifstream myfile("data\\audio\\outputFile.mp4", ios::binary);
+			ifstream myfile(audioTrackPath, ios::binary);
 			begin = myfile.tellg();
 			myfile.seekg(0, ios::end);
 			end = myfile.tellg();
@@ -805,10 +822,10 @@ void extractor::extractFromVideo(string filePath, int nv) {
 
 			if (fileSize > 15000) {
 
-				system("streaming_extractor_music.exe data\\audio\\outputFile.mp4 data\\audio\\extractor_music_output.json > nul:");
+				system((musicExtractorCommand + " " + audioTrackPath + " " + audioFeaturesPath + " > " + nullDevice).c_str());
 
 				// read a JSON file with audio features
-				std::ifstream i("data\\audio\\extractor_music_output.json");
+				std::ifstream i(audioFeaturesPath);
 				json j;
 				i >> j;
 				audioTemp[0] = (double)j["lowlevel"]["average_loudness"];
@@ -839,7 +856,7 @@ void extractor::extractFromVideo(string filePath, int nv) {
 
 				i.close();
 				report = " audio extracted!";
-				remove("data\\audio\\outputFile.mp4");
+				remove(audioTrackPath.c_str());
 
 			}
 			else { report = " no audio!"; }
@@ -848,171 +865,104 @@ void extractor::extractFromVideo(string filePath, int nv) {
 			cout << " [A] Audio status: " << status << report << endl;
 		}
 
-		/* samples for SVM classification*/
-		jInterestSample = {
-
-			{ "01",		redRatio },		        //red_ratio
-			{ "02",		SFLOWX2 },		        //sflowx_std
-			{ "03",     H1 },		            //dif_hues
-			{ "04",		length / fpsVec },		//duration
-			{ "05",     H4 },		            //hues_kurtosis
-			{ "06",     widthVec },		        //width
-			{ "07",     UFLOWY2 },              //uflowy_std
-			{ "08",     UFLOWY4 },              //uflowy_kurtosis
-			{ "09",     RG1 },                  //colorfullness_rg1
-			{ "10",     R3 },                   //red_moments3
-			{ "11",     F1 },                   //focus
-			{ "12",     greenRatio },           //green_ratio
-			{ "13",     YB1 },                  //colorfullness_yb1
-			{ "14",     F4 },                   //focus_kurtosis
-			{ "15",     UFLOWX1 },              //uflowx_mean
-			{ "16",     MAG4 },                 //mag_kurtosis
-			{ "17",     UFLOWX4 },              //uflowx_kurtosis
-			{ "18",     blueRatio },            //blue_ratio
-			{ "19",     facesVec },             //faces
-			{ "20",     E3 },                   //entropy_skewness
-			{ "21",     H2 },                   //hues_std
-			{ "22",     E1 },                   //entropy
-			{ "23",     heightVec },            //height
-			{ "24",     B3 },                   //blue_moments3
-			{ "25",     fpsVec / 60 },          //fps
-			{ "26",     H3 },                   //hues_skewness
-			{ "27",     UFLOWY3 },              //uflowy_skewness
-			{ "28",     B1 },                   //blue_moments1
-			{ "29",     F3 },                   //focus_skewness
-			{ "30",     eyesVec }               //smiles
-
-		};
-
-
-		jAestheticSample = {
-
-			{ "01",		SFLOWX2 },          //sflowx_std
-			{ "02",		widthVec },         //width
-			{ "03",		E2 },		        //entropy_std
-			{ "04",		F1 },		        //focus
-			{ "05",		facesRof3Vec },		//rule_of_thirds
-			{ "06",		MAG4 },		        //mag_kurtosis
-			{ "07",     fpsVec / 60 },		    //fps
-			{ "08",     SFLOWY2 },		    //sflowy_std
-			{ "09",     E3 },		        //entropy_skewness
-			{ "10",     SFLOWX3 },		    //sfx3
-			{ "11",     eyesVec },		    //smiles
-			{ "12",     SFLOWY1 },	     	//sflowy_mean
-			{ "13",     heightVec },		//height
-			{ "14",     H1},		        //dif_hues
-			{ "15",     SFLOWX1 },		     //sflowx mean
-			{ "16",     G2 },	          	//green moment 2
-			{ "17",     B4 },		        //blue_moments4
-			{ "18",     R1 },		        //red moment 1
-			{ "19",     shackiness },		//shackiness
-			{ "20",     MAG1 },		        //mag 1
-			{ "21",     SFLOWY4 },		    //sfy4
-			{ "22",     bgSubVec.at(4) }    //focus diff.
-
-		};
-
-
-
-		jsonAll = {
-
-			{ "width",   widthVec },
-			{ "height",   heightVec },
-			{ "red_ratio",       redRatio },
-			{ "red_moments1",   R1 },
-			{ "red_moments2",   R2 },
-			{ "green_ratio",     greenRatio },
-			{ "green_moments1", G1 },
-			{ "green_moments2", G2 },
-			{ "blue_ratio",      blueRatio },
-			{ "blue_moments1",  B1 },
-			{ "blue_moments2",  B2 },
-			{ "focus",           F1 },
-			{ "luminance",       LU1 },
-			{ "luminance_std",   LU2 },
-			{ "red_moments3",   R3 },
-			{ "red_moments4",   R4 },
-			{ "green_moments3", G3 },
-			{ "green_moments4", G4 },
-			{ "blue_moments3",  B3 },
-			{ "blue_moments4",  B4 },
-			{ "dif_hues",        H1 },
-			{ "faces",           facesVec },
-			{ "faces_area",      facesAreaVec },
-			{ "smiles",          eyesVec },
-			{ "rule_of_thirds",  facesRof3Vec },
-			{ "static_saliency", staticSaliencyVec },
-			{ "rank_sum",   rank_sum },
-			{ "fps",   fpsVec / 60 },
-			{ "shackiness",      shackiness },
-			{ "motion_mag",      MAG1 },
-			{ "fg_area",         bgSubVec.at(0) },
-			{ "shadow_area",     bgSubVec.at(1) },
-			{ "bg_area",         bgSubVec.at(2) },
-			{ "camera_move",     bgSubVec.at(3) },
-			{ "focus_diff",      bgSubVec.at(4) },
-			{ "hues_std",   H2 },
-			{ "hues_skewness",   H3 },
-			{ "hues_kurtosis",   H4 },
-			{ "eh_0",           (double)(edgeHistogramVec[0][0]) },
-			{ "eh_1",           (double)(edgeHistogramVec[0][1]) },
-			{ "eh_2",           (double)(edgeHistogramVec[0][2]) },
-			{ "eh_3",           (double)(edgeHistogramVec[0][3]) },
-			{ "eh_4",           (double)(edgeHistogramVec[0][4]) },
-			{ "eh_5",           (double)(edgeHistogramVec[0][5]) },
-			{ "eh_6",           (double)(edgeHistogramVec[0][6]) },
-			{ "eh_7",           (double)(edgeHistogramVec[0][7]) },
-			{ "eh_8",           (double)(edgeHistogramVec[0][8]) },
-			{ "eh_9",           (double)(edgeHistogramVec[0][9]) },
-			{ "eh_10",          (double)(edgeHistogramVec[0][10]) },
-			{ "eh_11",          (double)(edgeHistogramVec[0][11]) },
-			{ "eh_12",          (double)(edgeHistogramVec[0][12]) },
-			{ "eh_13",          (double)(edgeHistogramVec[0][13]) },
-			{ "eh_14",          (double)(edgeHistogramVec[0][14]) },
-			{ "eh_15",          (double)(edgeHistogramVec[0][15]) },
-			{ "eh_16",          (double)(edgeHistogramVec[0][16]) },
-			{ "entropy",        E1 },
-			{ "edge_strenght",   edgeStrenght },
-			{ "luminance_skewness",   LU3 },
-			{ "luminance_kurtosis",   LU4 },
-			{ "entropy_std",   E2 },
-			{ "entropy_skewness",   E3 },
-			{ "entropy_kurtosis",   E4 },
-			{ "focus_std",   F2 },
-			{ "focus_skewness",   F3 },
-			{ "focus_kurtosis",   F4 },
-			{ "mag_std",   MAG2 },
-			{ "mag_skewness",   MAG3 },
-			{ "mag_kurtosis",   MAG4 },
-			{ "uflowx_mean",   UFLOWX1 },
-			{ "uflowx_std",   UFLOWX2 },
-			{ "uflowx_skewness",   UFLOWX3 },
-			{ "uflowx_kurtosis",   UFLOWX4 },
-			{ "uflowy_mean",   UFLOWY1 },
-			{ "uflowy_std",   UFLOWY2 },
-			{ "uflowy_skewness",   UFLOWY3 },
-			{ "uflowy_kurtosis",   UFLOWY4 },
-			{ "sflowx_mean",   SFLOWX1 },
-			{ "sflowx_std",   SFLOWX2 },
-			{ "sflowx_skewness",   SFLOWX3 },
-			{ "sflowx_kurtosis",   SFLOWX4 },
-			{ "sflowy_mean",   SFLOWY1 },
-			{ "sflowy_std",   SFLOWY2 },
-			{ "sflowy_skewness",   SFLOWY3 },
-			{ "sflowy_kurtosis",   SFLOWY4 },
-			{ "colorfullness_rg1",   RG1 },
-			{ "colorfullness_rg2",   RG2},
-			{ "colorfullness_yb1",   YB1 },
-			{ "colorfullness_yb2",   YB2 },
-			{ "duration",   length / fpsVec },
-			{ "saturation_1",   SAT1},
-			{ "saturation_2",   SAT2 },
-			{ "brightness_1",   BRI1 },
-			{ "brightness_2",   BRI2 },
-			{ "colorfull_1",   CF1 },
-			{ "colorfull_2",   CF2 }
-
-		};
+		/* all features, aesthetic/interest predictions are set by the gallery */
+		features.clear();
+		features[FEAT_WIDTH] = widthVec;
+		features[FEAT_HEIGHT] = heightVec;
+		features[FEAT_RED_RATIO] = redRatio;
+		features[FEAT_RED_MOMENTS1] = R1;
+		features[FEAT_RED_MOMENTS2] = R2;
+		features[FEAT_GREEN_RATIO] = greenRatio;
+		features[FEAT_GREEN_MOMENTS1] = G1;
+		features[FEAT_GREEN_MOMENTS2] = G2;
+		features[FEAT_BLUE_RATIO] = blueRatio;
+		features[FEAT_BLUE_MOMENTS1] = B1;
+		features[FEAT_BLUE_MOMENTS2] = B2;
+		features[FEAT_FOCUS] = F1;
+		features[FEAT_LUMINANCE] = LU1;
+		features[FEAT_LUMINANCE_STD] = LU2;
+		features[FEAT_RED_MOMENTS3] = R3;
+		features[FEAT_RED_MOMENTS4] = R4;
+		features[FEAT_GREEN_MOMENTS3] = G3;
+		features[FEAT_GREEN_MOMENTS4] = G4;
+		features[FEAT_BLUE_MOMENTS3] = B3;
+		features[FEAT_BLUE_MOMENTS4] = B4;
+		features[FEAT_DIF_HUES] = H1;
+		features[FEAT_FACES] = facesVec;
+		features[FEAT_FACES_AREA] = facesAreaVec;
+		features[FEAT_SMILES] = eyesVec;
+		features[FEAT_RULE_OF_THIRDS] = facesRof3Vec;
+		features[FEAT_STATIC_SALIENCY] = staticSaliencyVec;
+		features[FEAT_RANK_SUM] = rank_sum;
+		features[FEAT_FPS] = fpsVec / 60;
+		features[FEAT_SHACKINESS] = shackiness;
+		features[FEAT_MOTION_MAG] = MAG1;
+		features[FEAT_FG_AREA] = bgSubVec.at(0);
+		features[FEAT_SHADOW_AREA] = bgSubVec.at(1);
+		features[FEAT_BG_AREA] = bgSubVec.at(2);
+		features[FEAT_CAMERA_MOVE] = bgSubVec.at(3);
+		features[FEAT_FOCUS_DIFF] = bgSubVec.at(4);
+		features[FEAT_HUES_STD] = H2;
+		features[FEAT_HUES_SKEWNESS] = H3;
+		features[FEAT_HUES_KURTOSIS] = H4;
+		features[FEAT_EH_0] = (double)(edgeHistogramVec[0][0]);
+		features[FEAT_EH_1] = (double)(edgeHistogramVec[0][1]);
+		features[FEAT_EH_2] = (double)(edgeHistogramVec[0][2]);
+		features[FEAT_EH_3] = (double)(edgeHistogramVec[0][3]);
+		features[FEAT_EH_4] = (double)(edgeHistogramVec[0][4]);
+		features[FEAT_EH_5] = (double)(edgeHistogramVec[0][5]);
+		features[FEAT_EH_6] = (double)(edgeHistogramVec[0][6]);
+		features[FEAT_EH_7] = (double)(edgeHistogramVec[0][7]);
+		features[FEAT_EH_8] = (double)(edgeHistogramVec[0][8]);
+		features[FEAT_EH_9] = (double)(edgeHistogramVec[0][9]);
+		features[FEAT_EH_10] = (double)(edgeHistogramVec[0][10]);
+		features[FEAT_EH_11] = (double)(edgeHistogramVec[0][11]);
+		features[FEAT_EH_12] = (double)(edgeHistogramVec[0][12]);
+		features[FEAT_EH_13] = (double)(edgeHistogramVec[0][13]);
+		features[FEAT_EH_14] = (double)(edgeHistogramVec[0][14]);
+		features[FEAT_EH_15] = (double)(edgeHistogramVec[0][15]);
+		features[FEAT_EH_16] = (double)(edgeHistogramVec[0][16]);
+		features[FEAT_ENTROPY] = E1;
+		features[FEAT_EDGE_STRENGHT] = edgeStrenght;
+		features[FEAT_LUMINANCE_SKEWNESS] = LU3;
+		features[FEAT_LUMINANCE_KURTOSIS] = LU4;
+		features[FEAT_ENTROPY_STD] = E2;
+		features[FEAT_ENTROPY_SKEWNESS] = E3;
+		features[FEAT_ENTROPY_KURTOSIS] = E4;
+		features[FEAT_FOCUS_STD] = F2;
+		features[FEAT_FOCUS_SKEWNESS] = F3;
+		features[FEAT_FOCUS_KURTOSIS] = F4;
+		features[FEAT_MAG_STD] = MAG2;
+		features[FEAT_MAG_SKEWNESS] = MAG3;
+		features[FEAT_MAG_KURTOSIS] = MAG4;
+		features[FEAT_UFLOWX_MEAN] = UFLOWX1;
+		features[FEAT_UFLOWX_STD] = UFLOWX2;
+		features[FEAT_UFLOWX_SKEWNESS] = UFLOWX3;
+		features[FEAT_UFLOWX_KURTOSIS] = UFLOWX4;
+		features[FEAT_UFLOWY_MEAN] = UFLOWY1;
+		features[FEAT_UFLOWY_STD] = UFLOWY2;
+		features[FEAT_UFLOWY_SKEWNESS] = UFLOWY3;
+		features[FEAT_UFLOWY_KURTOSIS] = UFLOWY4;
+		features[FEAT_SFLOWX_MEAN] = SFLOWX1;
+		features[FEAT_SFLOWX_STD] = SFLOWX2;
+		features[FEAT_SFLOWX_SKEWNESS] = SFLOWX3;
+		features[FEAT_SFLOWX_KURTOSIS] = SFLOWX4;
+		features[FEAT_SFLOWY_MEAN] = SFLOWY1;
+		features[FEAT_SFLOWY_STD] = SFLOWY2;
+		features[FEAT_SFLOWY_SKEWNESS] = SFLOWY3;
+		features[FEAT_SFLOWY_KURTOSIS] = SFLOWY4;
+		features[FEAT_COLORFULLNESS_RG1] = RG1;
+		features[FEAT_COLORFULLNESS_RG2] = RG2;
+		features[FEAT_COLORFULLNESS_YB1] = YB1;
+		features[FEAT_COLORFULLNESS_YB2] = YB2;
+		features[FEAT_DURATION] = length / fpsVec;
+		features[FEAT_SATURATION_1] = SAT1;
+		features[FEAT_SATURATION_2] = SAT2;
+		features[FEAT_BRIGHTNESS_1] = BRI1;
+		features[FEAT_BRIGHTNESS_2] = BRI2;
+		features[FEAT_COLORFULL_1] = CF1;
+		features[FEAT_COLORFULL_2] = CF2;
+		features.setStages(computedStages());		//Skipped steps are null, not 0
 
 	}
 	else { cout << " [!] Large Video!" << endl; }
@@ -1024,42 +974,73 @@ String extractor::getClassTextFromID(int ID)
 	return classNames.at(ID);
 }
 
-json extractor::getJsonA() {
+const FeatureRecord &extractor::getFeatures() {
 
-	return jAestheticSample;
+	return features;
 }
 
-json extractor::getJsonI() {
-
-	return jInterestSample;
-}
+void extractor::getConfigParams() {
 
-json extractor::getJsonAll() {
+	XmlFieldReader xml;
+	if (xml.load(configPath)) {
+		samplingFactor = xml.getInt("SAMPLING_FACTOR");
+		resizeMode = xml.getInt("RESIZE");
+		bgSub = xml.getInt("BGSUB") != 0;
+		haar = xml.getInt("HAAR") != 0;
+		edgeHist = xml.getInt("EDGE_HIST") != 0;
+		hsv = xml.getInt("HSV") != 0;
+		focus = xml.getInt("FOCUS") != 0;
+		dominantColors = xml.getInt("DOMINANT_COLORS") != 0;
+		opticalFlow = xml.getInt("FLOW") != 0;
+		entro = xml.getInt("ENTROPY") != 0;
+		semanticAnalysis = xml.getInt("SEMANTIC") != 0;
+		sSaliency = xml.getInt("SSALIENCY") != 0;
+		saveDominantPallete = xml.getInt("SAVEPALLETE") != 0;
+		colorfullness = xml.getInt("COLORFULLNESS") != 0;
+		audioAnalysis = xml.getInt("AUDIO") != 0;
+		predictOnly = xml.getInt("PREDICT_ONLY") != 0;
+	}
+	else {
+		cout << " [!] " << configPath << " not found, default extraction steps" << endl;
+	}
 
-	return jsonAll;
 }
 
-void extractor::getConfigParams() {
-
-	ofXml* xml = new ofXml(configPath);
-	if (xml->load(configPath)) {
-		samplingFactor = xml->getValue<int>("//SAMPLING_FACTOR");
-		resizeMode = xml->getValue<int>("//RESIZE");
-		bgSub = xml->getValue<bool>("//BGSUB");
-		haar = xml->getValue<bool>("//HAAR");
-		edgeHist = xml->getValue<bool>("//EDGE_HIST");
-		hsv = xml->getValue<bool>("//HSV");
-		focus = xml->getValue<bool>("//FOCUS");
-		dominantColors = xml->getValue<int>("//DOMINANT_COLORS");
-		opticalFlow = xml->getValue<bool>("//FLOW");
-		entro = xml->getValue<bool>("//ENTROPY");
-		semanticAnalysis = xml->getValue<bool>("//SEMANTIC");
-		sSaliency = xml->getValue<bool>("//SSALIENCY");
-		saveDominantPallete = xml->getValue<bool>("//SAVEPALLETE");
-		colorfullness = xml->getValue<bool>("//COLORFULLNESS");
-		audioAnalysis = xml->getValue<bool>("//AUDIO");
-	}
+//Turn on exactly the steps that compute the aesthetic and interestingness inputs,
+//everything else (edge histograms, saliency, semantic, audio...) is skipped
+void extractor::applyModelStages() {
+
+	unsigned stages = featureStages(aestheticInputs, AESTHETIC_INPUTS) |
+		featureStages(interestInputs, INTEREST_INPUTS);
+
+	colorfullness = (stages & STAGE_COLORFULLNESS) != 0;
+	focus = (stages & STAGE_FOCUS) != 0;
+	hsv = (stages & STAGE_HSV) != 0;
+	haar = (stages & STAGE_HAAR) != 0;
+	sSaliency = (stages & STAGE_SALIENCY) != 0;
+	opticalFlow = (stages & STAGE_FLOW) != 0;
+	bgSub = (stages & STAGE_BGSUB) != 0;
+	edgeHist = (stages & STAGE_EDGES) != 0;
+	entro = (stages & STAGE_ENTROPY) != 0;
+	dominantColors = false;
+	saveDominantPallete = false;
+	semanticAnalysis = false;
+	audioAnalysis = false;
+}
 
+unsigned extractor::computedStages() {
+
+	unsigned stages = STAGE_VIDEO | STAGE_COLORS | STAGE_MODEL;
+	if (colorfullness) stages |= STAGE_COLORFULLNESS;
+	if (focus) stages |= STAGE_FOCUS;
+	if (hsv) stages |= STAGE_HSV;
+	if (haar) stages |= STAGE_HAAR;
+	if (sSaliency) stages |= STAGE_SALIENCY;
+	if (opticalFlow) stages |= STAGE_FLOW;
+	if (bgSub) stages |= STAGE_BGSUB;
+	if (edgeHist) stages |= STAGE_EDGES;
+	if (entro) stages |= STAGE_ENTROPY;
+	return stages;
 }
 
 double extractor::ensureFormat(double input) {
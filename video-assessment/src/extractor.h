@@ -3,10 +3,10 @@
 // Created by Pedro Martins on 12-07-2017.
 //
 #pragma once
-#include "ofMain.h"
 #include "processing.h"
 #include "utility.h"
 #include "mlclass.h"
+#include "FeatureSchema.h"
 #include "opencv2/objdetect.hpp"
 #include <opencv2/opencv.hpp>
 #include "opencv2/videoio.hpp"
@@ -16,6 +16,7 @@
 #include <fstream>
 #include <iostream>
 #include <cstdlib>
+#include <sys/stat.h>
 
 using namespace saliency;
 using json = nlohmann::json;
@@ -48,9 +49,7 @@ public:
 	void extract(int frameCount);
 
 
-	json getJsonA();
-	json getJsonI();
-	json getJsonAll();
+	const FeatureRecord &getFeatures();		//Features of the last extracted video
 
 	int nFiles;                     //number of files to process
 	VideoCapture cap;               //current videoCapture object
@@ -90,15 +89,17 @@ public:
 
 	float accumStaticSaliency;
 	double staticSaliencyVec;
-	string configPath = "extractor_config.xml";               //Path to configuration file
+	string configPath = "data/extractor_config.xml";          //Path to configuration file
 	static string thumbnailFolderPath;				          //Path to thumbnails
 	int thumbnailHeight = 150;
 	int thumbnailWidth = 180;
 
-	bool extractor::exists_file(const std::string& name);
+	bool exists_file(const std::string& name);
 
 private:
 	void getConfigParams();
+	void applyModelStages();
+	unsigned computedStages();				//ExtractorStage bits of the steps that ran
 	//void extract(int frameCount);
 	
 
@@ -4,14 +4,33 @@
 using namespace std;
 
 
-void printRankedNames(vector<VideoFile> rankedFiles, string name = "") {
-	cout << "\n///////" << name << ": " << rankedFiles.size() << "\\\\\\\\\\\\" << endl;
-	for (File f : rankedFiles) {
-		cout << f.name << endl;
+namespace {
+
+	template <typename T>
+	float filterValue(const T &value)
+	{
+		return (float)value;
+	}
+
+	float filterValue(const string &)		//Text columns are never filter columns
+	{
+		return 0;
 	}
 }
 
-filtersPanel::filtersPanel()
+//Sort key of each SORT_n, same order as the enum
+static const FilterTable::Column sortColumns[] = {
+	FilterTable::RATE, FilterTable::RANKSUM, FilterTable::RED_RATIO, FilterTable::GREEN_RATIO,
+	FilterTable::BLUE_RATIO, FilterTable::ENTROPY, FilterTable::LUMINANCE, FilterTable::LUMINANCE_STD,
+	FilterTable::SHARPNESS, FilterTable::DIF_HUES, FilterTable::STATIC_SALIENCY, FilterTable::AVG_FACES,
+	FilterTable::FACE_AREA, FilterTable::RULE3, FilterTable::SMILES, FilterTable::FG_AREA,
+	FilterTable::SHADOW, FilterTable::FOCUS_DIF, FilterTable::MOTION, FilterTable::ABRUPTNESS,
+	FilterTable::SHAKE, FilterTable::SIMILARITY, FilterTable::LOUDNESS, FilterTable::COMPLEXITY,
+	FilterTable::BPM, FilterTable::DANCEABILITY, FilterTable::ONSET, FilterTable::CHORDS_CHANGE,
+	FilterTable::CF1, FilterTable::CF2, FilterTable::FILE_ID
+};
+
+filtersPanel::filtersPanel() : version(0)
 {
 
 }
@@ -28,17 +47,6 @@ void filtersPanel::draw()
 
 void filtersPanel::filter(VideoFile files[], int length, int choosenFileIndex)
 {
-	float colorSimilarity = 0.0, edgeSimilarity = 0.0, entropySimilarity = 0.0, motionSimilarity = 0.0;
-	int nsim = 0;
-	float  red1 = 0.0, green1 = 0.0, blue1 = 0.0, red2 = 0.0, green2 = 0.0, blue2 = 0.0;
-	int eh1 = 0, eh2 = 0, eh3 = 0, eh4 = 0, eh5 = 0, eh6, eh7 = 0, eh8 = 0, eh9 = 0, eh10 = 0,
-		eh11 = 0, eh12 = 0, eh13 = 0, eh14 = 0, eh15 = 0, eh16 = 0, ehGlobal = 0;
-	double entropy, motion = 0.0;
-	float f1_average_loudness = 0.0, f2_dynamic_complexity = 0.0, f3_bpm = 0.0, f4_danceability = 0.0,
-		f5_onset_rate = 0.0, f6_chords_change_rate = 0.0, f7_chords_number_rate = 0.0, f8_key_strength = 0.0,
-		f9_tuning_diatonic_strength = 0.0, f10_tuning_equal_tempered_deviation = 0.0,
-		f11_tuning_nontempered_energy_ratio = 0.0;
-
 	if (saveXML) {
 	
 		saveToXML("buttons.xml");
@@ -62,304 +70,36 @@ void filtersPanel::filter(VideoFile files[], int length, int choosenFileIndex)
 	if (lockTargetVideo)     //if similarity button is clicked on modify menu
 	{
 
+		unsigned facets = (colorSimilarityON ? SimilarityIndex::COLOR : 0) | (edgeSimilarityON ? SimilarityIndex::EDGES : 0) |
+			(entropySimilarityON ? SimilarityIndex::ENTROPY : 0) | (motionSimilarityON ? SimilarityIndex::MOTION : 0);
 		if (choosenFileIndex < 0) { cout << "no current selection!" << endl; }
+		else if (facets == 0) { cout << "no similarity criteria selected!" << endl; }
 		else {
-			if (colorSimilarityON)
-			{
-				nsim++;
-				red1 = files[choosenFileIndex].redMoments.first;		//red color value of file
-				green1 = files[choosenFileIndex].greenMoments.first;	//green color value of file
-				blue1 = files[choosenFileIndex].blueMoments.first;		//blue color value of file
-				red2 = files[choosenFileIndex].redMoments.second;		//red color value of file
-				green2 = files[choosenFileIndex].greenMoments.second;	//green color value of file
-				blue2 = files[choosenFileIndex].blueMoments.second;		//blue color value of file		
-			}
-			if (edgeSimilarityON)
-			{
-				nsim++;
-				eh1 = files[choosenFileIndex].eh1;
-				eh2 = files[choosenFileIndex].eh2;
-				eh3 = files[choosenFileIndex].eh3;
-				eh4 = files[choosenFileIndex].eh4;
-				eh5 = files[choosenFileIndex].eh5;
-				eh6 = files[choosenFileIndex].eh6;
-				eh7 = files[choosenFileIndex].eh7;
-				eh8 = files[choosenFileIndex].eh8;
-				eh9 = files[choosenFileIndex].eh9;
-				eh10 = files[choosenFileIndex].eh10;
-				eh11 = files[choosenFileIndex].eh11;
-				eh12 = files[choosenFileIndex].eh12;
-				eh13 = files[choosenFileIndex].eh13;
-				eh14 = files[choosenFileIndex].eh14;
-				eh15 = files[choosenFileIndex].eh15;
-				eh16 = files[choosenFileIndex].eh16;
-				ehGlobal = files[choosenFileIndex].ehGlobal;
-			}
-			if (entropySimilarityON)
-			{
-				nsim++;
-				entropy = files[choosenFileIndex].entropy;
-			}
-			if (motionSimilarityON)
-			{
-				nsim++;
-				motion = files[choosenFileIndex].motion;
-			}
-
-			for (int i = 0; i < length; ++i) {
-
-				if (colorSimilarityON)
-				{
-
-					colorSimilarity = sqrt(		        //Calculate color similarity 
-						pow(red1 - files[i].redMoments.first, 2) +
-						pow(green1 - files[i].greenMoments.first, 2) +
-						pow(blue1 - files[i].blueMoments.first, 2) +
-						pow(red2 - files[i].redMoments.second, 2) +
-						pow(green2 - files[i].greenMoments.second, 2) +
-						pow(blue2 - files[i].blueMoments.second, 2));
-
-					colorSimilarity = (10.0 - colorSimilarity) / 10.0;
-					//cout << red1<<" " << files[i].redMoments.first << endl;
-					//cout << colorSimilarity << endl;
-				}
-
-				if (edgeSimilarityON)
-				{
-					int equality = 0;
-
-					if (eh1 == files[i].eh1) equality++;
-					if (eh2 == files[i].eh2) equality++;
-					if (eh3 == files[i].eh3) equality++;
-					if (eh4 == files[i].eh4) equality++;
-					if (eh5 == files[i].eh5) equality++;
-					if (eh6 == files[i].eh6) equality++;
-					if (eh7 == files[i].eh7) equality++;
-					if (eh8 == files[i].eh8) equality++;
-					if (eh9 == files[i].eh9) equality++;
-					if (eh10 == files[i].eh10) equality++;
-					if (eh11 == files[i].eh11) equality++;
-					if (eh12 == files[i].eh12) equality++;
-					if (eh13 == files[i].eh13) equality++;
-					if (eh14 == files[i].eh14) equality++;
-					if (eh15 == files[i].eh15) equality++;
-					if (eh16 == files[i].eh16) equality++;
-
-					if (ehGlobal == files[i].ehGlobal) equality += 8;
-
-					edgeSimilarity = (double)equality / 24;
-					//cout << "same" << edgeSimilarity;
-
-				}
-				if (entropySimilarityON)
-				{
-					entropySimilarity = 1 - sqrt(		  //Calculate color similarity 
-						pow(entropy - files[i].entropy, 2));
-				}
-				if (motionSimilarityON)
-				{
-					motionSimilarity = 1 - sqrt(		   //Calculate color similarity 
-						pow(motion - files[i].motion, 2));
-				}
-
-				files[i].indexUpdate(((colorSimilarity + edgeSimilarity + entropySimilarity +
-					motionSimilarity) / nsim), files[choosenFileIndex].name);
-				//cout << entropySimilarity <<" " << motionSimilarity << endl;
-			}	//end of for cycle  					
-
-		}
-
-	}
-
-	if (f_ON || fadv_ON)
-	{
-
-		for (int i = 0; i < length; ++i) {				//For each file take values 
-			double red = files[i].redMoments.first;		//red color value of file
-			double green = files[i].greenMoments.first;	//green color value of file
-			double blue = files[i].blueMoments.first;		//blue color value of file
-			int rate = files[i].rate;					//rate of file
-
-			double redRatio = files[i].redRatio;
-			double greenRatio = files[i].greenRatio;
-			double blueRatio = files[i].blueRatio;
-			double entropy = files[i].entropy;
-			double luminance = files[i].luminance;
-			double sharpness = files[i].sharpness;
-			double abruptness = files[i].abruptness;
-			double motion = files[i].motion;
-
-			double rule3 = files[i].rule3;
-
-			double luminance_std = files[i].luminance_std;
-			double dif_hues = files[i].dif_hues;
-			double static_saliency = files[i].static_saliency;
-			double ranksum = files[i].ranksum;
-			double shadow = files[i].shadow;
-
-			double avgFaces = files[i].avgFaces;
-			double faceArea = files[i].faceArea;
-			double smiles = files[i].smiles;
-			double fgArea = files[i].faceArea;
-			double focus_dif = files[i].focus_dif;
-			double shake = files[i].shake;
-
-			double average_loudness = files[i].a1_average_loudness;
-			double dynamic_complexity = files[i].a2_dynamic_complexity;
-			double bpm = files[i].a3_bpm;
-			double danceability = files[i].a4_danceability;
-			double onset_rate = files[i].a5_onset_rate;
-			double chords_change_rate = files[i].a6_chords_change_rate;
-			double colourfulness_mean = files[i].cf1;
-			double colourfulness_std = files[i].cf2;
-
-
-			if ((redRatio >= f_redRatioP) &&		  
-				(greenRatio >= f_greenRatioP) &&	    
-				(blueRatio >= f_blueRatioP) &&	     
-				(rate >= f_rateP) &&	            
-				(entropy >= f_entropy) &&			    
-				(luminance >= f_luminaceP) &&      
-				(sharpness >= f_sharpness) &&           
-				(abruptness < f_abruptness) &&	       
-				(motion >= f_motion) &&	                
-				(luminance_std >= f_luminance_std) &&    
-				(dif_hues >= f_dif_hues) &&	           
-				(static_saliency >= f_static_saliency) && 
-				(colourfulness_mean >= f_cf1) &&
-				(colourfulness_std >= f_cf2) &&
-				(ranksum >= f_ranksum) &&	           
-				(shadow >= f_shadow) &&	                
-				(avgFaces >= f_avgFaces) &&	             
-				(faceArea >= f_faceArea) &&	             
-				(smiles >= f_smiles) &&	                
-				(fgArea >= f_fgArea) &&	                
-				(focus_dif >= f_focus_dif) &&
-				(shake < f_shake) &&
-				(rule3 >= f_rule3) &&
-				(average_loudness >= fa1_average_loudness) &&
-				(dynamic_complexity >= fa2_dynamic_complexity) &&
-				(bpm >= fa3_bpm) &&
-				(danceability >= fa4_danceability) &&
-				(onset_rate >= fa5_onset_rate) &&
-				(chords_change_rate >= fa6_chords_change_rate))
-
-			{
-				files[i].setVisible(true);
-				//cout << "filtering!"<<endl;
-			}
-			else
-			{
-				files[i].setVisible(false);
-			}
-
-			//////Human face filtering////////
-			if (f_humanFace)								   //If human face filtering is set
-			{
-				if (files[i].getVisible()) {				   //And file was visible
-					files[i].setVisible(files[i].humanFace);   //Set visible if there is human face
-				}
+			if (similarity.rows() != (size_t)length) {
+				setFiles(files, length);
 			}
-			//////Aesthetic filtering////////
-			if (f_predict)
-			{
-				if (files[i].getVisible()) {
-					files[i].setVisible(files[i].predict);
-				}
-			}
-			//////Interestingness filtering////////
-			if (f_interest)								      //If max interest filtering is set
-			{
-				if (files[i].getVisible()) {				  //And file was visible
-					files[i].setVisible(files[i].interest_1); //Set visible if there is interest
-				}
-			}
-
-			//////Keyword filtering////////
-			if (f_semantic)
-			{
-				if (files[i].getVisible()) {
 
-					files[i].setVisible(haveKey(files[i], userInsertKeywords, unionIntersect) && haveNotKey(files[i], userRemoveKeywords));
-				}
+			//Only the k most similar files get a similarity and reference, kept in memory; all others 0
+			vector<SimilarityIndex::Match> matches;
+			similarity.nearest(choosenFileIndex, facets, NUMBER_OF_RANKED_FILES, matches);
+			if ((similarity.missingFacets(choosenFileIndex) & facets) != 0)
+				cout << " [!] similarity criteria not computed for the selection are left out" << endl;
+			for (int i : similarRows) {
+				files[i].similarityIndex = 0;
+				files[i].referenceName = "none";
+				table.set(i, FilterTable::SIMILARITY, 0);
 			}
-
-			if (moreBP_gclear)
-			{
-				files[i].rate = 0.0;				
-			}
-
-		    if (moreBP_g1)
-			{
-
-				if (files[i].getVisible()) {
-					files[i].setVisible(files[i].rate == 1);
-				}
-			}
-			if (moreBP_g2)
-			{
-
-				if (files[i].getVisible()) {
-					files[i].setVisible(files[i].rate == 2);
-				}
-			}
-			 if (moreBP_g3)
-			{
-
-				if (files[i].getVisible()) {
-					files[i].setVisible(files[i].rate == 3);
-				}
-			}				
-
-			if (moreBP_v)
-			{
-				if (files[i].getVisible()) {
-					files[i].setVisible(files[i].ehGlobal == 1);
-				}
-
-			}
-			else if (moreBP_h)
-			{
-				if (files[i].getVisible()) {
-					files[i].setVisible(files[i].ehGlobal == 2);
-				}
-
-			}
-			else if (moreBP_45)
-			{
-				if (files[i].getVisible()) {
-					files[i].setVisible(files[i].ehGlobal == 3);
-				}
-
-			}
-			else if (moreBP_135)
-			{
-				if (files[i].getVisible()) {
-					files[i].setVisible(files[i].ehGlobal == 4);
-				}
-
-			}
-
-			if (s_ON && files[i].getVisible())			//Add all visible files to ranking
-			{
-				sortVector.push_back(files[i]);
-				numberOfSortedFiles = sortVector.size() < NUMBER_OF_RANKED_FILES ? sortVector.size() : NUMBER_OF_RANKED_FILES;
+			similarRows.clear();
+			for (const SimilarityIndex::Match &m : matches) {
+				files[m.row].similarityIndex = m.similarity;
+				files[m.row].referenceName = files[choosenFileIndex].name;		//Shown next to the score
+				table.set(m.row, FilterTable::SIMILARITY, m.similarity);
+				similarRows.push_back(m.row);
 			}
 		}
 	}
-	else												//No filters
-	{
-		for (int i = 0; i < length; ++i) { 				//All files visible
-			files[i].setVisible(true);
-		}
-	}
-
-	//Rank files
 
-	if (s_ON) {
-		ranking(sortVector);
-		hideUnrankedFiles(sortVector, files, length);
-	}
+	refilter(files, length);
 
 	if (resetFilterValues) {
 
@@ -414,21 +154,213 @@ void filtersPanel::filter(VideoFile files[], int length, int choosenFileIndex)
 		moreBP_g3 = false;
 		moreBP_gclear = false;
 
-		for (int i = 0; i < length; ++i) { 				//All files visible
-			files[i].setVisible(true);
+		table.showAll();
+		applyVisibility(files, length);
+	}
+}
+
+//Table of all files, thresholds, visibility and ranking from the panel values
+void filtersPanel::refilter(VideoFile files[], int length)
+{
+	if (table.rows() != (size_t)length) {
+		setFiles(files, length);
+	}
+
+	if (f_ON || fadv_ON)
+	{
+		//Thresholds kept in the table, only a moved slider costs anything
+		table.requireAtLeast(FilterTable::RED_RATIO, f_redRatioP);
+		table.requireAtLeast(FilterTable::GREEN_RATIO, f_greenRatioP);
+		table.requireAtLeast(FilterTable::BLUE_RATIO, f_blueRatioP);
+		table.requireAtLeast(FilterTable::RATE, f_rateP);
+		table.requireAtLeast(FilterTable::ENTROPY, f_entropy);
+		table.requireAtLeast(FilterTable::LUMINANCE, f_luminaceP);
+		table.requireAtLeast(FilterTable::SHARPNESS, f_sharpness);
+		table.requireBelow(FilterTable::ABRUPTNESS, f_abruptness);
+		table.requireAtLeast(FilterTable::MOTION, f_motion);
+		table.requireAtLeast(FilterTable::LUMINANCE_STD, f_luminance_std);
+		table.requireAtLeast(FilterTable::DIF_HUES, f_dif_hues);
+		table.requireAtLeast(FilterTable::STATIC_SALIENCY, f_static_saliency);
+		table.requireAtLeast(FilterTable::CF1, f_cf1);
+		table.requireAtLeast(FilterTable::CF2, f_cf2);
+		table.requireAtLeast(FilterTable::RANKSUM, f_ranksum);
+		table.requireAtLeast(FilterTable::SHADOW, f_shadow);
+		table.requireAtLeast(FilterTable::AVG_FACES, f_avgFaces);
+		table.requireAtLeast(FilterTable::FACE_AREA, f_faceArea);
+		table.requireAtLeast(FilterTable::SMILES, f_smiles);
+		table.requireAtLeast(FilterTable::FG_AREA, f_fgArea);
+		table.requireAtLeast(FilterTable::FOCUS_DIF, f_focus_dif);
+		table.requireBelow(FilterTable::SHAKE, f_shake);
+		table.requireAtLeast(FilterTable::RULE3, f_rule3);
+		table.requireAtLeast(FilterTable::LOUDNESS, fa1_average_loudness);
+		table.requireAtLeast(FilterTable::COMPLEXITY, fa2_dynamic_complexity);
+		table.requireAtLeast(FilterTable::BPM, fa3_bpm);
+		table.requireAtLeast(FilterTable::DANCEABILITY, fa4_danceability);
+		table.requireAtLeast(FilterTable::ONSET, fa5_onset_rate);
+		table.requireAtLeast(FilterTable::CHORDS_CHANGE, fa6_chords_change_rate);
+		table.showPassing();
+
+		if (f_humanFace) table.notEqual(FilterTable::HUMAN_FACE, 0);	//Human face filtering
+		if (f_predict) table.notEqual(FilterTable::PREDICT, 0);			//Aesthetic filtering
+		if (f_interest) table.notEqual(FilterTable::INTEREST, 0);		//Interestingness filtering
+
+		//////Keyword filtering, bitsets of the concept lists////////
+		if (f_semantic)
+		{
+			vector<int> include = ConceptIndex::parse(userInsertKeywords);
+			vector<int> exclude = ConceptIndex::parse(userRemoveKeywords);
+			vector<uint64_t> words;
+			if (!include.empty()) {
+				if (unionIntersect) concepts.matchAll(include, words);
+				else concepts.matchAny(include, words);
+				table.intersect(words);
+			}
+			if (!exclude.empty()) {
+				concepts.matchAny(exclude, words);
+				table.subtract(words);
+			}
+		}
+
+		if (moreBP_gclear)
+		{
+			for (int i = 0; i < length; ++i) {
+				files[i].rate = 0.0;
+				table.set(i, FilterTable::RATE, 0);
+			}
 		}
+
+		if (moreBP_g1) table.equal(FilterTable::RATE, 1);
+		if (moreBP_g2) table.equal(FilterTable::RATE, 2);
+		if (moreBP_g3) table.equal(FilterTable::RATE, 3);
+
+		if (moreBP_v) table.equal(FilterTable::EH_GLOBAL, 1);
+		else if (moreBP_h) table.equal(FilterTable::EH_GLOBAL, 2);
+		else if (moreBP_45) table.equal(FilterTable::EH_GLOBAL, 3);
+		else if (moreBP_135) table.equal(FilterTable::EH_GLOBAL, 4);
+	}
+	else												//No filters
+	{
+		table.showAll();
+	}
+	applyVisibility(files, length);
+
+	//Rank files
+
+	if (s_ON) {
+		ranking();
+		applyVisibility(files, length);
 	}
-	sortVector.clear();
 }
 
-void filtersPanel::ranking(vector<VideoFile> &files)
+//Mirror the filterable attributes of all files in the table
+void filtersPanel::setFiles(VideoFile files[], int length)
 {
-	size_t length = files.size();
-	if (length > 0) {
+	table.resize(length);
+	for (int i = 0; i < length; ++i) {
+		fillRow(i, files[i]);
+	}
+	similarity.resize(length);
+	similarRows.clear();
+	concepts.resize(length);
+	for (int i = 0; i < length; ++i) {
+		const VideoFile &f = files[i];
+		int ids[5] = { f.semanticID_1, f.semanticID_2, f.semanticID_3, f.semanticID_4, f.semanticID_5 };
+		for (int id : ids) {
+			if (id >= 0) concepts.add(i, id);	//-1 pads files with less than 5 concepts
+		}
+		float color[6] = { (float)f.redMoments.first, (float)f.greenMoments.first, (float)f.blueMoments.first,
+			(float)f.redMoments.second, (float)f.greenMoments.second, (float)f.blueMoments.second };
+		int edges[17] = { f.eh1, f.eh2, f.eh3, f.eh4, f.eh5, f.eh6, f.eh7, f.eh8, f.eh9, f.eh10, f.eh11, f.eh12,
+			f.eh13, f.eh14, f.eh15, f.eh16, f.ehGlobal };
+		similarity.setRow(i, color, edges, (float)f.entropy, (float)f.motion);
+		if (f.similarityIndex != 0) {
+			similarRows.push_back(i);			//Scores saved by older versions, cleared by the first query
+		}
+	}
+	for (int t = 0; t < (int)(sizeof(sortColumns) / sizeof(sortColumns[0])); ++t) {
+		table.buildOrder(sortColumns[t], t != SORT_30);		//File ID lowest first, all others highest
+	}
+	shownWords.clear();
+	order.resize(length);
+	for (int i = 0; i < length; ++i) {
+		order[i] = i;
+	}
+	version++;
+}
 
-		sortFiles(files);
+void filtersPanel::updateFile(int index, const VideoFile &file)
+{
+	if (index >= 0 && (size_t)index < table.rows()) {
+		fillRow(index, file);
+	}
+}
+
+const vector<int> &filtersPanel::displayOrder() const
+{
+	return order;
+}
 
+unsigned filtersPanel::displayVersion() const
+{
+	return version;
+}
+
+void filtersPanel::fillRow(size_t row, const VideoFile &file)
+{
+#define FILTER_ROW_VALUE(col, type, member, parent, feature, filter) \
+	if (FilterTable::filter != FilterTable::NO_FILTER) table.set(row, FilterTable::filter, filterValue(file.member));
+	FILE_COLUMNS(FILTER_ROW_VALUE)
+	VIDEO_COLUMNS(FILTER_ROW_VALUE)
+#undef FILTER_ROW_VALUE
+}
+
+//Write the table visibility to the files, only words that changed since last time
+void filtersPanel::applyVisibility(VideoFile files[], int length)
+{
+	const vector<uint64_t> &words = table.visibleWords();
+	bool full = shownWords.size() != words.size();
+	for (size_t w = 0; w < words.size(); ++w) {
+		if (!full && shownWords[w] == words[w]) {
+			continue;
+		}
+		version++;
+		size_t end = std::min((size_t)length, (w + 1) * 64);
+		for (size_t i = w * 64; i < end; ++i) {
+			files[i].setVisible(table.isVisible(i));
+		}
+	}
+	shownWords = words;
+}
+
+//Visible rows in the kept order of the sort column, no sorting here: the table
+//keeps one row order per sortable column up to date as values change
+void filtersPanel::ranking()
+{
+	if (sortType < 0 || sortType >= (int)(sizeof(sortColumns) / sizeof(sortColumns[0]))) {
+		return;
 	}
+	vector<int> ranked;
+	table.ranked(sortColumns[sortType], NUMBER_OF_RANKED_FILES, ranked);
+	if (ranked.empty()) {
+		return;
+	}
+
+	//Ranked rows first, then the others in their previous order
+	vector<char> isRanked(order.size(), 0);
+	table.hideAll();
+	for (int i : ranked) {
+		isRanked[i] = 1;
+		table.show(i);
+	}
+	size_t next = ranked.size();
+	ranked.resize(order.size());
+	for (int i : order) {
+		if (!isRanked[i]) {
+			ranked[next++] = i;
+		}
+	}
+	order.swap(ranked);
+	version++;
 }
 
 void filtersPanel::setup()
@@ -734,238 +666,6 @@ bool filtersPanel::ifClearGroupON()
 	return moreBP_gclear;
 }
 
-void filtersPanel::sortFiles(vector<VideoFile> &files)
-{
-			switch (sortType)
-			{
-			case 0:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.rate > rhs.rate; });
-				break;
-			case 1:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.ranksum > rhs.ranksum; });
-				break;
-			case 2:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.redRatio > rhs.redRatio; });
-				break;
-			case 3:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.greenRatio > rhs.greenRatio; });
-				break;
-			case 4:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.blueRatio > rhs.blueRatio; });
-				break;
-			case 5:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.entropy > rhs.entropy; });
-				break;
-			case 6:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.luminance > rhs.luminance; });
-				break;
-			case 7:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.luminance_std > rhs.luminance_std; });
-				break;
-			case 8:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.sharpness > rhs.sharpness; });
-				break;
-			case 9:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.dif_hues > rhs.dif_hues; });
-				break;
-			case 10:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.static_saliency > rhs.static_saliency; });
-				break;
-			case 11:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.avgFaces > rhs.avgFaces; });
-				break;
-			case 12:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.faceArea > rhs.faceArea; });
-				break;
-			case 13:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.rule3 > rhs.rule3; });
-				break;
-			case 14:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.smiles > rhs.smiles; });
-				break;
-			case 15:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.fgArea > rhs.fgArea; });
-				break;
-			case 16:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.shadow > rhs.shadow; });
-				break;
-			case 17:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.focus_dif > rhs.focus_dif; });
-				break;
-			case 18:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.motion > rhs.motion; });
-				break;
-			case 19:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.abruptness > rhs.abruptness; });
-				break;
-			case 20:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.shake > rhs.shake; });
-				break;
-			case 21:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.similarityIndex > rhs.similarityIndex; });
-				break;
-			case 22:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.a1_average_loudness > rhs.a1_average_loudness; });
-				break;
-			case 23:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.a2_dynamic_complexity > rhs.a2_dynamic_complexity; });
-				break;
-			case 24:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.a3_bpm > rhs.a3_bpm; });
-				break;
-			case 25:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.a4_danceability > rhs.a4_danceability; });
-				break;
-			case 26:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.a5_onset_rate > rhs.a5_onset_rate; });
-				break;
-			case 27:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.a6_chords_change_rate > rhs.a6_chords_change_rate; });
-				break;
-			case 28:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.cf1 > rhs.cf1; });
-				break;
-			case 29:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.cf2 > rhs.cf2; });
-				break;
-			case 30:
-				sort(files.begin(), files.end(), [](const VideoFile& lhs, const VideoFile& rhs)
-				{ return lhs.fileID < rhs.fileID; });
-				break;
-
-			};
-
-}
-
-void filtersPanel::hideUnrankedFiles(vector<VideoFile> rankedFiles, VideoFile allFiles[], int allLength)
-{
-	//All files visibiliy is set to false. Now we can look only for ranked files and set them on true
-	for (int i = 0; i < allLength; ++i) {
-		allFiles[i].setVisible(false);
-	}
-
-	//Set each ranked file visible with order of rankedFiles
-	for (int j = 0; j < rankedFiles.size(); ++j) {
-
-		for (int i = 0; i < allLength; ++i) {
-			if (rankedFiles[j].path == allFiles[i].path) {
-				allFiles[i].setVisible(true);
-				std::swap(allFiles[j], allFiles[i]);
-				break;
-			}
-		}
-	}
-}
-
-bool filtersPanel::haveKey(VideoFile file, string keywords, bool ui)
-{
-	bool retval = false;
-	int numberOfKeys = 0;
-	int detectedConcepts = 0;
-
-	if (keywords == "") {
-		retval = true;
-	}
-	else {
-		vector<int> v = split(keywords, ',');
-		numberOfKeys = v.size();
-
-		if (!ui) {
-
-			for (int i = 0; i < v.size(); i++)
-			{
-				if (file.semanticID_1 == v[i] || file.semanticID_2 == v[i] || file.semanticID_3 == v[i]
-					|| file.semanticID_4 == v[i] || file.semanticID_5 == v[i])
-				{
-					retval = true;
-				}
-			}
-		}
-		else {
-
-			for (int i = 0; i < v.size(); i++)
-			{
-				if (file.semanticID_1 == v[i]) { detectedConcepts++; }
-				if (file.semanticID_2 == v[i]) { detectedConcepts++; }
-				if (file.semanticID_3 == v[i]) { detectedConcepts++; }
-				if (file.semanticID_4 == v[i]) { detectedConcepts++; }
-				if (file.semanticID_5 == v[i]) { detectedConcepts++; }
-
-				if (detectedConcepts == numberOfKeys)
-				{
-					retval = true;
-				}
-			}
-		}
-	}
-	return retval;
-}
-
-bool filtersPanel::haveNotKey(VideoFile file, string keywords)
-{
-	bool retval = true;
-
-	if (keywords == "") {
-		retval = true;
-	}
-	else {
-		vector<int> v = split(keywords, ',');
-
-		for (int i = 0; i < v.size(); i++) {
-
-			if (file.semanticID_1 == v[i] || file.semanticID_2 == v[i] || file.semanticID_3 == v[i]
-				|| file.semanticID_4 == v[i] || file.semanticID_5 == v[i])
-			{
-				retval = false;
-			}
-		}
-	}
-	return retval;
-}
-
-vector<int> filtersPanel::split(const string &s, char delim) {
-	vector<int> result;
-	stringstream ss(s);
-	string item;
-
-	while (getline(ss, item, delim)) {
-
-		result.push_back(stoi(item));
-	}
-
-	return result;
-}
-
 void filtersPanel::saveToXML(string xmlfilePath)
 {
 	//similarityIndex = (double)newIndex;		//Rate update
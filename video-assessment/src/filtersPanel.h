@@ -2,6 +2,9 @@
 #include "File.h"
 #include "VideoFile.h"
 #include "ofxButtons.h"
+#include "FilterTable.h"
+#include "SimilarityIndex.h"
+#include "ConceptIndex.h"
 
 #define NUMBER_OF_RANKED_FILES 1000
 
@@ -13,7 +16,12 @@ public:
 
 	void draw();							                            //Draw gui window
 	void filter(VideoFile files[], int length, int choosenFileIndex);	//Filters array 
+	void refilter(VideoFile files[], int length);		//Current filters and sort again, after files were added
 	void setup();
+	void setFiles(VideoFile files[], int length);		//Build the filter table, after loading files
+	void updateFile(int index, const VideoFile &file);	//Refresh a table row after rate edits
+	const vector<int> &displayOrder() const;			//File indexes in the order to lay them out
+	unsigned displayVersion() const;					//Changes whenever visibility or display order do
 	//Check if similarity title or value was clicked
 	bool isModifyClicked(int x, int y);
 	//Check if similarity data was already extracted
@@ -157,21 +165,16 @@ private:
 	void loadFromXML(string xmlfilePath);
 
 
-	bool haveKey(VideoFile file, string keywords, bool ui);
-	bool haveNotKey(VideoFile file, string keywords);
-	vector<int> split(const string &s, char delim);
-	vector<VideoFile> sortVector;		//Vector of ranked files
-	size_t numberOfSortedFiles;		//Number of ranked files
+	FilterTable table;					//Filterable attributes of the files, same order
+	vector<uint64_t> shownWords;		//Visibility last written to the files
+	void fillRow(size_t row, const VideoFile &file);
+	void applyVisibility(VideoFile files[], int length);
 
-	void ranking(vector<VideoFile> &files);		//Rank array (sort)
-	void sortFiles(vector<VideoFile> &files);	//Sort 
-	//Show only n top ranked files
-	void hideUnrankedFiles(vector<VideoFile> rankedFiles, VideoFile allFiles[], int allLenght);
-
-	struct sort_by_attr {
-		bool operator()(const std::pair<int, double> &left, const std::pair<int, double> &right) {
-			return left.second < right.second;
-		}
-	};
+	ConceptIndex concepts;				//Semantic concept IDs of the files, same order
+	SimilarityIndex similarity;			//Similarity features of the files, same order
+	vector<int> similarRows;			//Rows with a nonzero similarity
+	vector<int> order;					//Display order of the rows, a permutation
+	unsigned version;					//Bumped on visibility/order changes
+	void ranking();						//Top NUMBER_OF_RANKED_FILES visible rows first, the rest hidden
 };
 
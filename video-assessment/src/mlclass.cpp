@@ -2,8 +2,14 @@
 // Created by pedro on 21-07-2017.
 //
 
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
 #include "mlclass.h"
+#include "CsvTable.h"
+#include "MappedFile.h"
+#include "RffModel.h"
 
 using namespace std;
 using namespace cv;
@@ -23,10 +29,28 @@ string i_binary_scores = "data/SVM/i_beach_gui/i_beach_bin_gui.csv";
 string i_feature_vector = "data/SVM/i_beach_gui/i_beach_train_gui_nonorm_norm.csv";
 string i_maxmin_path = "data/SVM/i_beach_gui/i_beach_train_gui_nonorm_maxmin.csv";
 
-vector< vector<double> > trainingData, a_maxmin, i_maxmin;
-vector< int > trainingLabels;
+//Trained model bundles (svm + maxmin), rebuilt when the csvs above change
+string a_model_path = "data/SVM/A2018C22/aesthetic_model.yml";
+string i_model_path = "data/SVM/i_beach_gui/interest_model.yml";
+
+vector< vector<double> > a_maxmin, i_maxmin;
+vector<float> a_min, a_scale, i_min, i_scale;		//maxmin as affine normalisation
 Ptr<SVM> svm_a;
 Ptr<SVM> svm_i;
+RffModel rff_a, rff_i;								//Optional, see buildApprox
+
+namespace {
+
+	const char *modelFormat = "vqa-svm-1";		//Bump when the bundle layout changes
+
+	void hashBytes(uint64_t &h, const char *data, size_t length)
+	{
+		for (size_t i = 0; i < length; ++i) {
+			h ^= (unsigned char)data[i];
+			h *= 1099511628211ull;				//FNV-1a 64
+		}
+	}
+}
 
 mlclass::mlclass() { 
 	//ctor
@@ -40,227 +64,297 @@ void mlclass::init() {
 
 	auto start = chrono::high_resolution_clock::now();
 
-	svm_a = processSVM(a_binary_scores, a_feature_vector, "Aesthetic", 5.12, 0.107374);
-	svm_i = processSVM(i_binary_scores, i_feature_vector, "Interestingness", 1, 0.2);
+	ModelSource aesthetic = { a_binary_scores, a_feature_vector, a_maxmin_path, 5.12, 0.107374 };
+	ModelSource interest = { i_binary_scores, i_feature_vector, i_maxmin_path, 1, 0.2 };
+	svm_a = loadOrTrain(aesthetic, a_model_path, "Aesthetic", AESTHETIC_INPUTS, a_maxmin);
+	svm_i = loadOrTrain(interest, i_model_path, "Interestingness", INTEREST_INPUTS, i_maxmin);
+	prepareNormalisation(a_maxmin, a_min, a_scale);
+	prepareNormalisation(i_maxmin, i_min, i_scale);
 
 	auto end = chrono::high_resolution_clock::now();
 
-	cout << "\n [!] Classifiers created in " << duration_cast<chrono::milliseconds>(end - start).count()
+	cout << "\n [!] Classifiers ready in " << duration_cast<chrono::milliseconds>(end - start).count()
 		<< " ms" << endl;
+};
 
-	a_maxmin.assign(2, vector<double>(22, 0));
-	i_maxmin.assign(2, vector<double>(30, 0));
+//Use the bundle if its training data is unchanged (it may come from the offline
+//trainer with other data and C/gamma), otherwise train from the defaults and save it
+Ptr<SVM> mlclass::loadOrTrain(const ModelSource &defaults, string model_path, string classifier_name,
+	size_t inputs, vector< vector<double> > &maxmin) {
 
-	ifstream inputData(a_maxmin_path);
-	string current_line;
-	int y = 0;
+	Ptr<SVM> s = loadModel(model_path, inputs, maxmin);
+	if (!s.empty()) {
+		cout << " [M] " << classifier_name << " model loaded: " << model_path << endl;
+		return s;
+	}
 
-	while (getline(inputData, current_line)) {
+	cout << " [M] " << classifier_name << " model missing or outdated, training" << endl;
+	readMaxMin(defaults.maxminPath, inputs, maxmin);
+	s = processSVM(defaults.binaryScores, defaults.featureVector, classifier_name, defaults.C, defaults.G);
+	if (!s.empty() && !saveModel(model_path, defaults, s, maxmin)) {
+		cout << " [!] " << classifier_name << " model not saved: " << model_path << endl;
+	}
+	return s;
+}
 
-		stringstream temp(current_line);
-		std::string single_value;
-		int z = 0;
-		while (getline(temp, single_value, ',')) {
+//Hash of the training files and parameters, stored in the bundle
+string mlclass::hashTrainingData(const ModelSource &source) {
 
-			a_maxmin[y][z] = atof(single_value.c_str()); 		
-			z++;
+	uint64_t h = 14695981039346656037ull;
+	hashBytes(h, modelFormat, strlen(modelFormat));
+	string files[] = { source.binaryScores, source.featureVector, source.maxminPath };
+	for (const string &f : files) {
+		MappedFile data;
+		if (data.open(f)) {
+			hashBytes(h, data.data(), data.size());
 		}
-		y++;
+		hashBytes(h, "|", 1);
 	}
-	inputData.close();
-
-	ifstream inData(i_maxmin_path);
-	string curr_line;
-	int y2 = 0;
+	hashBytes(h, (const char *)&source.C, sizeof(source.C));
+	hashBytes(h, (const char *)&source.G, sizeof(source.G));
 
-	while (getline(inData, curr_line)) {
+	char hex[17];
+	snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)h);
+	return hex;
+}
 
-		stringstream temp(curr_line);
-		std::string single_value;
-		int z = 0;
-		while (getline(temp, single_value, ',')) {
+//Bundle whose recorded training files still hash the same. inputs 0 accepts any width
+Ptr<SVM> mlclass::loadModel(string model_path, size_t inputs, vector< vector<double> > &maxmin) {
 
-			i_maxmin[y2][z] = atof(single_value.c_str());
-			z++;
+	try {
+		FileStorage fs(model_path, FileStorage::READ);
+		if (!fs.isOpened()) {
+			return Ptr<SVM>();
+		}
+		ModelSource source;
+		string storedHash;
+		fs["labels"] >> source.binaryScores;
+		fs["features"] >> source.featureVector;
+		fs["maxmin_source"] >> source.maxminPath;
+		fs["C"] >> source.C;
+		fs["gamma"] >> source.G;
+		fs["training_hash"] >> storedHash;
+		if (storedHash.empty() || storedHash != hashTrainingData(source)) {
+			return Ptr<SVM>();
 		}
-		y2++;
+		Mat mm;
+		fs["maxmin"] >> mm;
+		if (mm.rows != 2 || mm.type() != CV_64FC1 || (inputs != 0 && mm.cols != (int)inputs)) {
+			cout << " [!] " << model_path << " has " << mm.cols << " inputs, expected " << inputs << endl;
+			return Ptr<SVM>();
+		}
+		Ptr<SVM> s = SVM::create();
+		s->read(fs["svm"]);
+		if (!s->isTrained()) {
+			return Ptr<SVM>();
+		}
+		maxmin.assign(2, vector<double>(mm.cols, 0));
+		for (int z = 0; z < mm.cols; ++z) {
+			maxmin[0][z] = mm.at<double>(0, z);
+			maxmin[1][z] = mm.at<double>(1, z);
+		}
+		return s;
 	}
-	inData.close();
-};
+	catch (const cv::Exception &e) {
+		cout << " [!] model not readable: " << model_path << " " << e.what() << endl;
+		return Ptr<SVM>();
+	}
+}
 
-Ptr<SVM> mlclass::processSVM(string binary_scores, string feature_vector,
-	string classifier_name, double C, double G) {
+bool mlclass::saveModel(string model_path, const ModelSource &source, const Ptr<SVM> &s,
+	const vector< vector<double> > &maxmin) {
 
-	vector <int> countResult = mlclass::countData(feature_vector);
-	int numberOfFeatures = countResult[1];
-	int total_items = countResult[0];
+	try {
+		Mat mm(2, (int)maxmin[0].size(), CV_64FC1);
+		for (int y = 0; y < 2; ++y)
+			for (int z = 0; z < mm.cols; ++z)
+				mm.at<double>(y, z) = maxmin[y][z];
 
-	//allocate the arrays
-	trainingData.assign(total_items, vector<double>(numberOfFeatures, 0));
-	trainingLabels.assign(total_items, 0);
+		FileStorage fs(model_path, FileStorage::WRITE);
+		if (!fs.isOpened()) {
+			return false;
+		}
+		fs << "training_hash" << hashTrainingData(source);
+		fs << "labels" << source.binaryScores;
+		fs << "features" << source.featureVector;
+		fs << "maxmin_source" << source.maxminPath;
+		fs << "C" << source.C;
+		fs << "gamma" << source.G;
+		fs << "maxmin" << mm;
+		fs << "svm" << "{";
+		s->write(fs);
+		fs << "}";
+		return true;
+	}
+	catch (const cv::Exception &e) {
+		cout << " [!] " << e.what() << endl;
+		return false;
+	}
+}
 
-	///Print current classifier stats
-	cout << "\n [M] dataset items: " << total_items << endl;
-	cout << " [M] features: " << numberOfFeatures << endl;
+//C-SVC with RBF kernel, parameters must be set before training to be used
+Ptr<SVM> mlclass::createSVM(double C, double G) {
 
-	/// Set up label data----------------------------------------------------
-	ifstream inputBinaryData(binary_scores);
-	std::string current_binary_line;
-	int x = 0;
+	Ptr<SVM> s = SVM::create();
+	s->setType(SVM::C_SVC);
+	s->setKernel(SVM::RBF);
+	s->setC(C);
+	s->setGamma(G);
+	s->setTermCriteria(TermCriteria(TermCriteria::MAX_ITER, 10000, 1e-6));
+	return s;
+}
 
-	while (getline(inputBinaryData, current_binary_line)) {
+//Max (row 0) and min (row 1) of each feature in the training set, for normalisation
+bool mlclass::readMaxMin(string maxmin_path, size_t inputs, vector< vector<double> > &maxmin) {
 
-		int temp = atoi(current_binary_line.c_str());
-		trainingLabels[x] = temp;
-		x++;
+	maxmin.assign(2, vector<double>(inputs, 0));
+	CsvTable data;
+	if (!data.load(maxmin_path)) {
+		cout << " [!] maxmin file missing: " << maxmin_path << endl;
+		return false;
 	}
+	for (size_t y = 0; y < 2; ++y)
+		for (size_t z = 0; z < inputs; ++z)
+			maxmin[y][z] = data.get(y, z);
+	return true;
+}
 
-	/// Set up feature data------------------------------------------------------
-	ifstream inputFeatureData(feature_vector);
-	string current_training_line;
-	int y = 0;
-
-	// Start reading lines as long as there are lines in the file
-	while (getline(inputFeatureData, current_training_line)) {
-
-		stringstream temp(current_training_line);
-		std::string single_value;
-		int z = 0;
-		while (getline(temp, single_value, ',')) {
+Ptr<SVM> mlclass::processSVM(string binary_scores, string feature_vector,
+	string classifier_name, double C, double G) {
 
-			trainingData[y][z] = atof(single_value.c_str()); // convert the string element to a float value
-			z++;
-		}
-		y++;
+	CsvTable labels;
+	CsvTable samples;
+	if (!labels.load(binary_scores) || !samples.load(feature_vector)) {
+		cout << " [!] " << classifier_name << " training data missing" << endl;
+		return Ptr<SVM>();
 	}
+	int total_items = (int)samples.rows();
+	int numberOfFeatures = (int)samples.cells(0);
 
-	///Setup the input matrixes for training and evaluating of the svm /////////////
-	Mat trainingDataMat = Mat(total_items, numberOfFeatures, CV_32FC1);
+	///Print current classifier stats
+	cout << "\n [M] dataset items: " << total_items << endl;
+	cout << " [M] features: " << numberOfFeatures << endl;
 
+	///Setup the input matrixes for training, straight from the parsed csv
+	Mat trainingDataMat(total_items, numberOfFeatures, CV_32FC1);
 	for (int i = 0; i < total_items; ++i)
 		for (int j = 0; j < numberOfFeatures; ++j)
 		{
-			trainingDataMat.at<float>(i, j) = trainingData.at(i).at(j);
+			trainingDataMat.at<float>(i, j) = (float)samples.get(i, j);
 		}
-	Mat trainingLabelsMat = Mat(total_items, 1, CV_32SC1);
-	memcpy(trainingLabelsMat.data, trainingLabels.data(), trainingLabels.size() * sizeof(int));
+	Mat trainingLabelsMat(total_items, 1, CV_32SC1);
+	for (int i = 0; i < total_items; ++i)
+	{
+		trainingLabelsMat.at<int>(i, 0) = labels.getInt(i, 0);	//Missing labels read as 0
+	}
 
 	cout << " [M] " << trainingDataMat.size() << " feature vector" << endl;
-	cout << " [M] " << trainingLabels.size() << " labels vector" << endl;
+	cout << " [M] " << labels.rows() << " labels vector" << endl;
 
 	// Create the SVM
-	Ptr<SVM> s = SVM::create();
-	s->setType(SVM::C_SVC);
-	s->setKernel(SVM::RBF);
-	s->setTermCriteria(TermCriteria(TermCriteria::MAX_ITER, 10000, 1e-6));
+	Ptr<SVM> s = createSVM(C, G);
 	s->train(trainingDataMat, ROW_SAMPLE, trainingLabelsMat);
-	s->setC(C);
-	s->setGamma(G);
 
 	cout << " [M] " << classifier_name << " Classifier generated!" << " C: "<<C<<" G: "<<G<< endl;
 	return s;
 }
 
-//Predict sample
-int mlclass::predictSample(json jSample, int c) {
+//Predict one video, logs the decision
+int mlclass::predictSample(const FeatureRecord &features, int c) {
 
+	Model model = (c == 0) ? AESTHETIC : INTEREST;
+	fillSamples(&features, 1, model, sampleRow);
+	Mat result = predictBatch(sampleRow, model);
 
-	size_t sSize = jSample.size();
-	float* sampleData = new float[sSize];
-	float* sampleNormData = new float[sSize];
-	int ps = 0;
-
-	for (json::iterator it = jSample.begin(); it != jSample.end(); ++it) {
-		//std::cout << it.key() << " : " << it.value() << "\n";
-		sampleData[ps] = it.value();
-		ps++;
+	int finalResponse = result.empty() ? 0 : (int)result.at<float>(0, 0);
+	if (model == AESTHETIC) {
+		cout << " [M] aesthetics: " << finalResponse << endl;
 	}
-
-	if (c == 0) {
-		
-	for (int p = 0; p < sSize; p++)
-			{
-				double fMax = a_maxmin[0][p];
-				//cout << " max " << fMax;
-				double fMin = a_maxmin[1][p];
-				//cout << " min " << fMin;
-				double cValue = sampleData[p];
-				//cout << " value " << cValue;
-				double denominator = (fMax - fMin);
-				double numerator = (cValue - fMin);
-				//cout << "dois " << dois << " um " << um <<" ";
-				float result = (float)numerator / denominator;
-				result = (result > 1) ? 1 : result;
-				result = (result < 0) ? 0 : result;
-				sampleNormData[p] = result;
-				//cout <<" res "<< sampleNormData[p] << " ";
-			}
-		
-	//cout << endl;
+	else {
+		cout << " [M] interestingness: " << finalResponse << endl;
 	}
-	else if (c == 1) {
+	return finalResponse;
+}
 
-		for (int p = 0; p < sSize; p++)
-		{
-			double fMax = i_maxmin[0][p];
-			double fMin = i_maxmin[1][p];
-			double cValue = sampleData[p];
-			double denominator = (fMax - fMin);
-			double numerator = (cValue - fMin);
-			float result = (float)numerator / denominator;
-			result = (result > 1) ? 1 : result;
-			result = (result < 0) ? 0 : result;
-			sampleNormData[p] = result;
-		}
+//Model inputs of each record, one row per record
+void mlclass::fillSamples(const FeatureRecord *records, size_t count, Model model, Mat &samples) {
 
-		//cout << endl;
+	const VideoFeature *inputs = (model == AESTHETIC) ? aestheticInputs : interestInputs;
+	size_t sSize = (model == AESTHETIC) ? AESTHETIC_INPUTS : INTEREST_INPUTS;
+	samples.create((int)count, (int)sSize, CV_32FC1);
+	for (size_t i = 0; i < count; ++i) {
+		projectFeatures(records[i], inputs, sSize, samples.ptr<float>((int)i));
 	}
+}
 
-	Mat sampleDataMat(1, sSize, CV_32FC1, sampleNormData);
-
-	///Show the decision given by the SVM
+//Normalise every row to the training range with one clamped affine pass and
+//predict all rows in a single call. Scratch matrices are reused between calls.
+Mat mlclass::predictBatch(const Mat &samples, Model model) {
 
-	int finalResponse = 0;
-	if (c == 0) {
-		finalResponse = (int)svm_a->predict(sampleDataMat);
-		cout << " [M] aesthetics: " << finalResponse << endl;
-	}
-	else if (c == 1) {
-		finalResponse = (int)svm_i->predict(sampleDataMat);
-		cout << " [M] interestingness: " << finalResponse << endl;
+	const Ptr<SVM> &svm = (model == AESTHETIC) ? svm_a : svm_i;
+	const vector<float> &mins = (model == AESTHETIC) ? a_min : i_min;
+	const vector<float> &scales = (model == AESTHETIC) ? a_scale : i_scale;
+	if (svm.empty() || samples.type() != CV_32FC1 || samples.cols != (int)mins.size()) {
+		cout << " [!] predictBatch(): classifier " << model << " not available or wrong sample size" << endl;
+		return Mat();
 	}
-	delete[] sampleData;
-	return finalResponse;
 
+	normaliseSamples(samples, mins, scales, normalized);
+	svm->predict(normalized, responses);
+	return responses;
 }
-vector <int> mlclass::countData(string f_vector)
-{
 
-	/// Count features and samples //////////////////////////////////////////////////////
-	ifstream inputFeatureCountData(f_vector.c_str());
-	string current_line;
-	int sampleCount = 0;     //number of samples
-	int featureCount = 0;    //number of features
+//Approximate both models with the given number of random features (256-2048 is
+//usually enough, see svm-approx for the agreement with the exact models)
+bool mlclass::buildApprox(int components, unsigned seed) {
 
-	// Start reading lines as long as there are lines in the file
-	while (getline(inputFeatureCountData, current_line))
-	{
-		stringstream temp(current_line);
-		string single_value;
+	bool a = rff_a.build(svm_a, components, seed);
+	bool i = rff_i.build(svm_i, components, seed);
+	cout << " [M] approximate classifiers: " << components << " components"
+		<< (a && i ? "" : ", not all models available") << endl;
+	return a && i;
+}
 
-		if (sampleCount == 0)
-		{
-			while (getline(temp, single_value, ','))
-				featureCount++;
+Mat mlclass::predictApprox(const Mat &samples, Model model) {
+
+	RffModel &rff = (model == AESTHETIC) ? rff_a : rff_i;
+	const vector<float> &mins = (model == AESTHETIC) ? a_min : i_min;
+	const vector<float> &scales = (model == AESTHETIC) ? a_scale : i_scale;
+	if (rff.empty() || samples.type() != CV_32FC1 || samples.cols != (int)mins.size()) {
+		cout << " [!] predictApprox(): approximation " << model << " not built or wrong sample size" << endl;
+		return Mat();
+	}
+
+	normaliseSamples(samples, mins, scales, normalized);
+	rff.predict(normalized, responses);
+	return responses;
+}
+
+//Clamped (x - min) * scale of every row
+void mlclass::normaliseSamples(const Mat &samples, const vector<float> &mins, const vector<float> &scales, Mat &out) {
+
+	out.create(samples.rows, samples.cols, CV_32FC1);
+	const float *mn = mins.data();
+	const float *sc = scales.data();
+	int cols = samples.cols;
+	for (int r = 0; r < samples.rows; ++r) {
+		const float *in = samples.ptr<float>(r);
+		float *o = out.ptr<float>(r);
+		for (int j = 0; j < cols; ++j) {
+			o[j] = std::min(1.0f, std::max(0.0f, (in[j] - mn[j]) * sc[j]));
 		}
-		sampleCount++;
 	}
+}
 
-	inputFeatureCountData.close();
-	vector<int> result;
-	result.assign(2, 0);
+//Float min and 1/(max-min) per feature, 0 scale for constant features
+void mlclass::prepareNormalisation(const vector< vector<double> > &maxmin, vector<float> &mins, vector<float> &scales) {
 
-	result[0] = sampleCount;
-	result[1] = featureCount;
-	return result;
-}
\ No newline at end of file
+	size_t n = maxmin.empty() ? 0 : maxmin[0].size();
+	mins.assign(n, 0);
+	scales.assign(n, 0);
+	for (size_t p = 0; p < n; ++p) {
+		double range = maxmin[0][p] - maxmin[1][p];
+		mins[p] = (float)maxmin[1][p];
+		scales[p] = range != 0 ? (float)(1.0 / range) : 0;
+	}
+}
@@ -5,13 +5,12 @@
 #pragma once
 #include <opencv2/ml.hpp>
 #include <fstream>
-#include <json.hpp>
+#include <sstream>
+#include "FeatureSchema.h"
 using namespace std;
 using namespace cv;
 using namespace cv::ml;
 
-using json = nlohmann::json;
-
 class mlclass {
 
 public:
@@ -20,15 +19,49 @@ public:
 
 	virtual ~mlclass();
 
+	enum Model
+	{
+		AESTHETIC,
+		INTEREST
+	};
+
 	void init();
-	int predictSample(json jSample, int c);
+	int predictSample(const FeatureRecord &features, int c);	//c: 0 aesthetic, 1 interestingness
+	void fillSamples(const FeatureRecord *records, size_t count, Model model, Mat &samples);
+	Mat predictBatch(const Mat &samples, Model model);	//N x inputs CV_32FC1 -> N x 1 labels, valid until next call
+	bool buildApprox(int components, unsigned seed = 1);	//Random Fourier feature models for bulk triage
+	Mat predictApprox(const Mat &samples, Model model);	//As predictBatch, with the approximate models
+
 
+	//Where a model is trained from; recorded in the bundle and hashed
+	struct ModelSource
+	{
+		string binaryScores;		//Labels, one per line
+		string featureVector;		//Normalised training samples
+		string maxminPath;			//Max and min rows used for normalisation
+		double C;
+		double G;
+	};
+
+	static Ptr<SVM> createSVM(double C, double G);
+	static string hashTrainingData(const ModelSource &source);
+	static Ptr<SVM> loadModel(string model_path, size_t inputs, vector< vector<double> > &maxmin);
+	static bool saveModel(string model_path, const ModelSource &source, const Ptr<SVM> &s,
+		const vector< vector<double> > &maxmin);
+	static bool readMaxMin(string maxmin_path, size_t inputs, vector< vector<double> > &maxmin);
+	static void prepareNormalisation(const vector< vector<double> > &maxmin, vector<float> &mins, vector<float> &scales);
+	static void normaliseSamples(const Mat &samples, const vector<float> &mins, const vector<float> &scales, Mat &out);
 
 protected:
+	Ptr<SVM> loadOrTrain(const ModelSource &defaults, string model_path, string classifier_name,
+		size_t inputs, vector< vector<double> > &maxmin);
+
 	Ptr<SVM> processSVM(string binary_scores, string feature_vector,
 		string classifier_name, double C, double G);
 
-	vector <int> countData(string f_vector);
 private:
+	Mat sampleRow;			//Scratch for predictSample
+	Mat normalized;			//Scratch for predictBatch
+	Mat responses;
 
 };
\ No newline at end of file
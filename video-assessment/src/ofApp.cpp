@@ -20,6 +20,11 @@ void ofApp::update(){
 	gallery.update();
 }
 
+//--------------------------------------------------------------
+void ofApp::exit(){
+	gallery.exit();
+}
+
 //--------------------------------------------------------------
 void ofApp::draw(){
  
@@ -0,0 +1,478 @@
+//End-to-end extraction throughput on generated clips. Deterministic test clips
+//(moving shapes, a pan, colour ramps, a static scene and, with --face, faces
+//moving over it) are written with VideoWriter at several sizes and durations,
+//then extractFromVideo runs on them with generated extractor configs:
+//
+//  clips     every clip, all features on (the shipped defaults)
+//  features  reference clip, all features, none, and each feature left out;
+//            the time a feature adds is its cost share. --combinations all
+//            runs every subset of the features instead
+//  settings  reference clip, every RESIZE and SAMPLING_FACTOR value
+//
+//For each run: frames/sec of the source clip, wall time and peak RSS. Writes
+//one JSON document. Run from bin/ (models, cascades and templates in data/).
+//
+//  extraction-bench [--out extraction-bench.json] [--work bench] [--face <image>]...
+//                   [--sizes 320x240,640x480,1920x1080] [--seconds 2,10] [--fps 25]
+//                   [--reference shapes_640x480_2s] [--combinations single|all] [--seed 1]
+
+#include "extractor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+	struct Options
+	{
+		string out = "extraction-bench.json";
+		string work = "bench";					//Generated clips, configs and thumbnails
+		vector<string> faces;
+		vector<Size> sizes = { Size(320, 240), Size(640, 480), Size(1920, 1080) };
+		vector<int> seconds = { 2, 10 };
+		int fps = 25;
+		string reference = "shapes_640x480_2s";
+		string combinations = "single";
+		unsigned seed = 1;
+	};
+
+	struct Clip
+	{
+		string name;
+		string scene;
+		string path;
+		Size size;
+		int seconds;
+		int frames;
+	};
+
+	//extractor_config.xml keys, in file order
+	typedef vector<pair<string, int> > Config;
+
+	//Switches of the feature steps. AUDIO is kept off: generated clips have no audio track
+	const char *featureKeys[] = { "BGSUB", "HAAR", "EDGE_HIST", "ENTROPY", "HSV", "FOCUS", "DOMINANT_COLORS",
+		"SSALIENCY", "FLOW", "SEMANTIC", "COLORFULLNESS" };
+	const int FEATURE_KEYS = sizeof(featureKeys) / sizeof(featureKeys[0]);
+
+	void usage()
+	{
+		cout << "usage: extraction-bench [--out <json>] [--work <folder>] [--face <image>]..." << endl
+			<< "                        [--sizes WxH,...] [--seconds s,...] [--fps 25]" << endl
+			<< "                        [--reference <clip>] [--combinations single|all] [--seed 1]" << endl;
+	}
+
+	vector<string> split(const string &text, char separator)
+	{
+		vector<string> parts;
+		stringstream stream(text);
+		string part;
+		while (getline(stream, part, separator)) {
+			if (!part.empty()) parts.push_back(part);
+		}
+		return parts;
+	}
+
+	bool parseOptions(int argc, char **argv, Options &options)
+	{
+		for (int i = 1; i < argc; ++i) {
+			string key = argv[i];
+			if (i + 1 >= argc) {
+				cout << " [!] missing value for " << key << endl;
+				return false;
+			}
+			const char *value = argv[++i];
+			if (key == "--out") options.out = value;
+			else if (key == "--work") options.work = value;
+			else if (key == "--face") options.faces.push_back(value);
+			else if (key == "--fps") options.fps = atoi(value);
+			else if (key == "--reference") options.reference = value;
+			else if (key == "--combinations") options.combinations = value;
+			else if (key == "--seed") options.seed = (unsigned)strtoul(value, nullptr, 10);
+			else if (key == "--sizes") {
+				options.sizes.clear();
+				for (const string &s : split(value, ',')) {
+					int w = 0, h = 0;
+					if (sscanf(s.c_str(), "%dx%d", &w, &h) != 2 || w < 16 || h < 16) {
+						cout << " [!] size must be WxH: " << s << endl;
+						return false;
+					}
+					options.sizes.push_back(Size(w, h));
+				}
+			}
+			else if (key == "--seconds") {
+				options.seconds.clear();
+				for (const string &s : split(value, ',')) {
+					options.seconds.push_back(max(1, atoi(s.c_str())));
+				}
+			}
+			else {
+				cout << " [!] unknown option " << key << endl;
+				return false;
+			}
+		}
+		if (options.combinations != "single" && options.combinations != "all") {
+			cout << " [!] --combinations must be single or all" << endl;
+			return false;
+		}
+		return options.fps > 0 && !options.sizes.empty() && !options.seconds.empty();
+	}
+
+	bool makeFolder(const string &path)
+	{
+		struct stat buffer;
+		if (stat(path.c_str(), &buffer) == 0) {
+			return (buffer.st_mode & S_IFDIR) != 0;
+		}
+#ifdef _WIN32
+		return _mkdir(path.c_str()) == 0;
+#else
+		return mkdir(path.c_str(), 0755) == 0;
+#endif
+	}
+
+	//Peak resident set in KB. On Linux the high water mark is reset before every
+	//run (clear_refs), elsewhere it is the peak of the whole process so far
+	void resetPeakRss()
+	{
+#ifdef __linux__
+		ofstream clear("/proc/self/clear_refs");
+		clear << "5";
+#endif
+	}
+
+	long peakRssKb()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			return (long)(counters.PeakWorkingSetSize / 1024);
+		}
+		return 0;
+#elif defined(__linux__)
+		ifstream status("/proc/self/status");
+		string line;
+		while (getline(status, line)) {
+			if (line.compare(0, 6, "VmHWM:") == 0) {
+				return atol(line.c_str() + 6);
+			}
+		}
+		return 0;
+#else
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss / 1024;			//Bytes on macOS
+#endif
+	}
+
+	//Twice as wide as the frame so it can be panned: colour ramp, shapes and texture
+	Mat backdrop(Size size, unsigned seed)
+	{
+		Mat image(size.height, size.width * 2, CV_8UC3);
+		for (int y = 0; y < image.rows; ++y) {
+			Vec3b *row = image.ptr<Vec3b>(y);
+			for (int x = 0; x < image.cols; ++x) {
+				row[x] = Vec3b((uchar)(255 * x / image.cols), (uchar)(255 * y / image.rows), (uchar)(128 + 127 * ((x / 40 + y / 40) % 2)));
+			}
+		}
+		RNG rng(seed);
+		double unit = size.width / 320.0;
+		for (int i = 0; i < 40; ++i) {
+			Point center(rng.uniform(0, image.cols), rng.uniform(0, image.rows));
+			Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+			int radius = (int)(rng.uniform(6, 40) * unit);
+			if (i % 2 == 0) circle(image, center, radius, color, FILLED);
+			else rectangle(image, Rect(center.x, center.y, radius * 2, radius), color, FILLED);
+		}
+		return image;
+	}
+
+	//Frame t of a scene, the same for the same seed
+	Mat sceneFrame(const string &scene, int t, int frames, const Mat &back, const vector<Mat> &faces, unsigned seed)
+	{
+		Size size(back.cols / 2, back.rows);
+		Mat frame;
+		if (scene == "pan") {
+			int x = (int)((double)size.width * t / max(1, frames - 1));
+			back(Rect(x, 0, size.width, size.height)).copyTo(frame);
+		}
+		else if (scene == "ramp") {
+			Mat hsv(size, CV_8UC3);
+			for (int y = 0; y < size.height; ++y) {
+				Vec3b *row = hsv.ptr<Vec3b>(y);
+				for (int x = 0; x < size.width; ++x) {
+					row[x] = Vec3b((uchar)((x * 180 / size.width + t * 2) % 180), 200, (uchar)(60 + 195 * y / size.height));
+				}
+			}
+			cvtColor(hsv, frame, COLOR_HSV2BGR);
+		}
+		else {
+			back(Rect(0, 0, size.width, size.height)).copyTo(frame);
+		}
+
+		if (scene == "shapes") {
+			RNG rng(seed);
+			for (int i = 0; i < 8; ++i) {
+				Point start(rng.uniform(0, size.width), rng.uniform(0, size.height));
+				Point speed(rng.uniform(-6, 7), rng.uniform(-4, 5));
+				Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+				int radius = size.width / 20 + i * 2;
+				Point p(((start.x + speed.x * t) % size.width + size.width) % size.width,
+					((start.y + speed.y * t) % size.height + size.height) % size.height);
+				circle(frame, p, radius, color, FILLED);
+			}
+		}
+		else if (scene == "static") {
+			Mat noise(size, CV_8UC3);
+			RNG rng(seed + t);
+			rng.fill(noise, RNG::UNIFORM, 0, 6);		//Sensor noise only
+			frame += noise;
+		}
+		else if (scene == "faces") {
+			for (size_t i = 0; i < faces.size(); ++i) {
+				int h = size.height / 3;
+				int w = max(1, faces[i].cols * h / max(1, faces[i].rows));
+				if (w >= size.width) continue;
+				Mat face;
+				resize(faces[i], face, Size(w, h), 0, 0, INTER_AREA);
+				int x = (int)((size.width - w) * (0.5 + 0.5 * sin(t * 0.05 + i)));
+				int y = (int)((size.height - h) * (0.2 + 0.6 * i / max((size_t)1, faces.size())));
+				face.copyTo(frame(Rect(x, y, w, h)));
+			}
+		}
+		return frame;
+	}
+
+	bool writeClip(Clip &clip, int fps, const vector<Mat> &faces, unsigned seed)
+	{
+		VideoWriter writer(clip.path, VideoWriter::fourcc('M', 'J', 'P', 'G'), fps, clip.size, true);
+		if (!writer.isOpened()) {
+			cout << " [!] cannot write " << clip.path << endl;
+			return false;
+		}
+		Mat back = backdrop(clip.size, seed);
+		for (int t = 0; t < clip.frames; ++t) {
+			writer << sceneFrame(clip.scene, t, clip.frames, back, faces, seed);
+		}
+		return true;
+	}
+
+	Config defaultConfig()
+	{
+		Config config;
+		config.push_back(make_pair("SAMPLING_FACTOR", 1));
+		config.push_back(make_pair("RESIZE", 1));
+		for (int f = 0; f < FEATURE_KEYS; ++f) {
+			config.push_back(make_pair(featureKeys[f], string(featureKeys[f]) == "DOMINANT_COLORS" ? 0 : 1));
+		}
+		config.push_back(make_pair("SAVEPALLETE", 0));
+		config.push_back(make_pair("AUDIO", 0));
+		config.push_back(make_pair("PREDICT_ONLY", 0));
+		return config;
+	}
+
+	void setKey(Config &config, const string &key, int value)
+	{
+		for (pair<string, int> &c : config) {
+			if (c.first == key) c.second = value;
+		}
+	}
+
+	bool writeConfig(const string &path, const Config &config)
+	{
+		ofstream file(path);
+		if (!file.is_open()) {
+			return false;
+		}
+		file << "<CONFIG>\n";
+		for (const pair<string, int> &c : config) {
+			file << "\t<" << c.first << ">" << c.second << "</" << c.first << ">\n";
+		}
+		file << "</CONFIG>\n";
+		return file.good();
+	}
+
+	json configJson(const Config &config)
+	{
+		json j;
+		for (const pair<string, int> &c : config) {
+			j[c.first] = c.second;
+		}
+		return j;
+	}
+
+}
+
+int main(int argc, char **argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		usage();
+		return 1;
+	}
+	if (!makeFolder(options.work)) {
+		cout << " [!] cannot create " << options.work << endl;
+		return 1;
+	}
+
+	vector<Mat> faces;
+	for (const string &path : options.faces) {
+		Mat face = imread(path, IMREAD_COLOR);
+		if (face.empty()) {
+			cout << " [!] face not loaded: " << path << endl;
+			return 1;
+		}
+		faces.push_back(face);
+	}
+	vector<string> scenes = { "shapes", "pan", "ramp", "static" };
+	if (!faces.empty()) {
+		scenes.push_back("faces");
+	}
+
+	//Clips
+	vector<Clip> clips;
+	json clipsJson = json::array();
+	for (const string &scene : scenes) {
+		for (const Size &size : options.sizes) {
+			for (int seconds : options.seconds) {
+				Clip clip;
+				clip.scene = scene;
+				clip.size = size;
+				clip.seconds = seconds;
+				clip.frames = seconds * options.fps;
+				clip.name = scene + "_" + to_string(size.width) + "x" + to_string(size.height) + "_" + to_string(seconds) + "s";
+				clip.path = options.work + "/" + clip.name + ".avi";
+				if (!writeClip(clip, options.fps, faces, options.seed)) {
+					return 1;
+				}
+				clips.push_back(clip);
+				json c;
+				c["name"] = clip.name;
+				c["scene"] = scene;
+				c["width"] = size.width;
+				c["height"] = size.height;
+				c["seconds"] = seconds;
+				c["frames"] = clip.frames;
+				clipsJson.push_back(c);
+			}
+		}
+	}
+	vector<Clip>::iterator reference = find_if(clips.begin(), clips.end(), [&](const Clip &c) { return c.name == options.reference; });
+	if (reference == clips.end()) {
+		cout << " [!] reference clip not generated: " << options.reference << endl;
+		return 1;
+	}
+	cout << " [*] " << clips.size() << " clips written to " << options.work << endl;
+
+	extractor ex;
+	ex.configPath = options.work + "/extractor_config.xml";
+	extractor::thumbnailFolderPath = options.work;
+	ex.init();
+
+	json runs = json::array();
+	int runCount = 0;
+	//One extraction of a clip with a config, timed as a whole
+	auto run = [&](const string &phase, const Clip &clip, const Config &config) {
+		if (!writeConfig(ex.configPath, config)) {
+			cout << " [!] cannot write " << ex.configPath << endl;
+			return -1.0;
+		}
+		resetPeakRss();
+		auto start = chrono::high_resolution_clock::now();
+		ex.extractFromVideo(clip.path, ++runCount);
+		auto end = chrono::high_resolution_clock::now();
+		double ms = chrono::duration<double, milli>(end - start).count();
+		json r;
+		r["phase"] = phase;
+		r["clip"] = clip.name;
+		r["config"] = configJson(config);
+		r["ms"] = ms;
+		r["frames"] = clip.frames;
+		r["frames_per_sec"] = clip.frames / (ms / 1000);
+		r["peak_rss_kb"] = peakRssKb();
+		runs.push_back(r);
+		cerr << " [*] " << phase << " " << clip.name << ": " << ms << " ms, " << clip.frames / (ms / 1000) << " frames/s" << endl;
+		return ms;
+	};
+
+	for (const Clip &clip : clips) {
+		run("clips", clip, defaultConfig());
+	}
+
+	//Time each feature adds to the reference clip, defaults on
+	Config all = defaultConfig();
+	Config none = defaultConfig();
+	for (int f = 0; f < FEATURE_KEYS; ++f) {
+		setKey(none, featureKeys[f], 0);
+	}
+	double allMs = run("features", *reference, all);
+	double noneMs = run("features", *reference, none);
+	json share;
+	if (options.combinations == "all") {
+		for (unsigned mask = 1; mask + 1 < (1u << FEATURE_KEYS); ++mask) {
+			Config config = defaultConfig();
+			for (int f = 0; f < FEATURE_KEYS; ++f) {
+				setKey(config, featureKeys[f], (mask >> f) & 1);
+			}
+			run("features", *reference, config);
+		}
+	}
+	for (int f = 0; f < FEATURE_KEYS; ++f) {
+		if (string(featureKeys[f]) == "DOMINANT_COLORS") {
+			Config with = all;
+			setKey(with, featureKeys[f], 1);					//Off by default, its cost is measured on top
+			double ms = run("features", *reference, with);
+			share[featureKeys[f]] = allMs > 0 ? max(0.0, ms - allMs) / allMs : 0;
+			continue;
+		}
+		Config without = all;
+		setKey(without, featureKeys[f], 0);
+		double ms = run("features", *reference, without);
+		share[featureKeys[f]] = allMs > 0 ? max(0.0, allMs - ms) / allMs : 0;
+	}
+	share["DECODE_AND_FIXED"] = allMs > 0 ? noneMs / allMs : 0;		//Reading frames and steps always run
+
+	//Frame size and frame skipping on the reference clip
+	for (int resizeMode = 0; resizeMode <= 3; ++resizeMode) {
+		for (int sampling : { 1, 5, 10 }) {
+			Config config = defaultConfig();
+			setKey(config, "RESIZE", resizeMode);
+			setKey(config, "SAMPLING_FACTOR", sampling);
+			run("settings", *reference, config);
+		}
+	}
+
+	json report;
+	report["benchmark"] = "extraction";
+	report["opencv"] = CV_VERSION;
+	report["threads"] = getNumThreads();
+	report["fps"] = options.fps;
+	report["seed"] = options.seed;
+	report["reference"] = reference->name;
+	report["clips"] = clipsJson;
+	report["runs"] = runs;
+	report["feature_share"] = share;
+
+	ofstream file(options.out);
+	if (!file.is_open()) {
+		cout << " [!] cannot write " << options.out << endl;
+		return 1;
+	}
+	file << report.dump(2) << endl;
+	cerr << " [*] " << runs.size() << " runs saved to " << options.out << endl;
+	return 0;
+}
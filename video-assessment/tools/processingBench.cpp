@@ -0,0 +1,325 @@
+//Microbenchmarks of the per-frame extraction kernels (processing:: and the
+//extractor's frame steps), called the way extractFromVideo calls them, on
+//synthetic frames and optional fixture images at the extraction sizes and 1080p.
+//Writes one JSON document: ns per frame, operator new calls per call, throughput.
+//Run from bin/ (haar cascades and rule of thirds template are read from data/).
+//
+//  processing-bench [--out <json>] [--fixture <image>]... [--kernel <name>]...
+//                   [--min-ms 300] [--min-iterations 5] [--seed 1] [--threads -1]
+//
+//Kernels: focus, hues, colors, myEntropy, entropy, edgeHistogram, haar,
+//dominantColors, staticSaliency. Progress goes to stderr, JSON to --out or stdout.
+
+#include "extractor.h"
+#include "processing.h"
+#include "utility.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+
+using namespace std;
+
+//operator new calls of this executable only. cv::Mat data comes from OpenCV's
+//fastMalloc and is never counted, nor is anything the OpenCV DLLs allocate on
+//MSVC (a DLL doesn't see a replaced operator new). OpenCV 3.2 has no allocator
+//statistics, so the count tracks our own vectors and containers, not Mat buffers
+namespace {
+	atomic<size_t> heapAllocations(0);
+}
+
+void *operator new(size_t size)
+{
+	heapAllocations++;
+	void *p = malloc(size ? size : 1);
+	if (p == nullptr) {
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	free(p);
+}
+
+namespace {
+
+	struct Options
+	{
+		string out;
+		vector<string> fixtures;
+		vector<string> kernels;					//Empty = all
+		double minMs = 300;
+		int minIterations = 5;
+		unsigned seed = 1;
+		int threads = -1;						//OpenCV default
+	};
+
+	struct Frame
+	{
+		string source;							//"synthetic" or fixture path
+		Mat image;								//BGR, like VideoCapture frames
+	};
+
+	struct Kernel
+	{
+		string name;
+		function<void(const Mat &)> prepare;	//Per frame setup, not timed
+		function<void(Mat &)> run;
+	};
+
+	void usage()
+	{
+		cout << "usage: processing-bench [--out <json>] [--fixture <image>]... [--kernel <name>]..." << endl
+			<< "                        [--min-ms 300] [--min-iterations 5] [--seed 1] [--threads -1]" << endl;
+	}
+
+	bool parseOptions(int argc, char **argv, Options &options)
+	{
+		for (int i = 1; i < argc; ++i) {
+			string key = argv[i];
+			if (i + 1 >= argc) {
+				cout << " [!] missing value for " << key << endl;
+				return false;
+			}
+			const char *value = argv[++i];
+			if (key == "--out") options.out = value;
+			else if (key == "--fixture") options.fixtures.push_back(value);
+			else if (key == "--kernel") options.kernels.push_back(value);
+			else if (key == "--min-ms") options.minMs = atof(value);
+			else if (key == "--min-iterations") options.minIterations = atoi(value);
+			else if (key == "--seed") options.seed = (unsigned)strtoul(value, nullptr, 10);
+			else if (key == "--threads") options.threads = atoi(value);
+			else {
+				cout << " [!] unknown option " << key << endl;
+				return false;
+			}
+		}
+		return options.minIterations > 0 && options.minMs >= 0;
+	}
+
+	//Colour ramp, shapes scaled to the frame and fine noise, the same picture at every size
+	Mat syntheticFrame(int width, int height, unsigned seed)
+	{
+		Mat frame(height, width, CV_8UC3);
+		for (int y = 0; y < height; ++y) {
+			Vec3b *row = frame.ptr<Vec3b>(y);
+			for (int x = 0; x < width; ++x) {
+				row[x] = Vec3b((uchar)(255 * x / width), (uchar)(255 * y / height), (uchar)(255 * (x + y) / (width + height)));
+			}
+		}
+		RNG rng(seed);
+		double unit = width / 320.0;
+		for (int i = 0; i < 24; ++i) {
+			Point center(rng.uniform(0, width), rng.uniform(0, height));
+			Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+			int size = (int)(rng.uniform(8, 48) * unit);
+			if (i % 2 == 0) {
+				circle(frame, center, size, color, FILLED);
+			}
+			else {
+				rectangle(frame, Rect(center.x, center.y, size * 2, size), color, FILLED);
+			}
+		}
+		Mat noise(frame.size(), CV_8UC3);
+		rng.fill(noise, RNG::UNIFORM, 0, 16);
+		frame += noise;
+		return frame;
+	}
+
+	bool selected(const Options &options, const string &kernel)
+	{
+		return options.kernels.empty() || find(options.kernels.begin(), options.kernels.end(), kernel) != options.kernels.end();
+	}
+
+}
+
+int main(int argc, char **argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		usage();
+		return 1;
+	}
+	if (options.threads >= 0) {
+		setNumThreads(options.threads);
+	}
+
+	const Size sizes[] = { Size(320, 240), Size(480, 360), Size(640, 480), Size(1920, 1080) };
+	vector<Frame> frames;
+	for (const Size &size : sizes) {
+		Frame f;
+		f.source = "synthetic";
+		f.image = syntheticFrame(size.width, size.height, options.seed);
+		frames.push_back(f);
+	}
+	for (const string &path : options.fixtures) {
+		Mat image = imread(path, IMREAD_COLOR);
+		if (image.empty()) {
+			cout << " [!] fixture not loaded: " << path << endl;
+			return 1;
+		}
+		for (const Size &size : sizes) {
+			Frame f;
+			f.source = path;
+			resize(image, f.image, size, 0, 0, INTER_AREA);
+			frames.push_back(f);
+		}
+	}
+
+	//Kernel state as extractFromVideo keeps it
+	processing pp;
+	utility uu;
+	extractor ex;
+	CascadeClassifier faceCascade, aditionalCascade;
+	bool cascades = faceCascade.load(ex.face_cascade_name) && aditionalCascade.load(ex.aditional_cascade_name);
+	Mat rule = imread("data/templates/rule.jpg", IMREAD_GRAYSCALE);
+	Mat ruleImage;
+	Ptr<Saliency> saliencyAlgorithm = Saliency::create("SPECTRAL_RESIDUAL");
+	Mat grey, histogram;
+	const int histSize = 256;
+
+	vector<Kernel> kernels;
+	Kernel k;
+	k.prepare = [](const Mat &) {};
+	k.name = "focus";
+	k.run = [&](Mat &frame) { pp.processFocus(frame); };
+	kernels.push_back(k);
+	k.name = "hues";
+	k.run = [&](Mat &frame) { pp.processHues(frame); };
+	kernels.push_back(k);
+	k.name = "colors";
+	k.run = [&](Mat &frame) { ex.processColors(frame); };
+	kernels.push_back(k);
+	k.name = "myEntropy";
+	k.prepare = [&](const Mat &frame) { cvtColor(frame, grey, CV_BGR2GRAY); };
+	k.run = [&](Mat &) { histogram = pp.myEntropy(grey, histSize); };
+	kernels.push_back(k);
+	k.name = "entropy";
+	k.prepare = [&](const Mat &frame) { cvtColor(frame, grey, CV_BGR2GRAY); histogram = pp.myEntropy(grey, histSize); };
+	k.run = [&](Mat &) { pp.entropy(histogram, grey.size(), histSize); };
+	kernels.push_back(k);
+	k.prepare = [](const Mat &) {};
+	k.name = "edgeHistogram";							//16 blocks, as one frame
+	k.run = [&](Mat &frame) {
+		vector<Mat> blocks = pp.splitMat(frame, 0.25, true);
+		for (int i = 0; i < 16; i++) {
+			pp.processEdgeHistogram(blocks[i]);
+		}
+	};
+	kernels.push_back(k);
+	if (cascades && !rule.empty()) {
+		k.name = "haar";
+		k.prepare = [&](const Mat &frame) { ruleImage = uu.resizeRuleImg(rule, frame); };
+		k.run = [&](Mat &frame) { pp.processHaarCascade(frame, faceCascade, aditionalCascade, true, ruleImage); };
+		kernels.push_back(k);
+		k.prepare = [](const Mat &) {};
+	}
+	else {
+		cerr << " [!] haar skipped: cascades or data/templates/rule.jpg not found, run from bin/" << endl;
+	}
+	k.name = "dominantColors";
+	k.run = [&](Mat &frame) { pp.find_dominant_colors(frame, 5, 0, 0, false); };
+	kernels.push_back(k);
+	k.name = "staticSaliency";
+	k.run = [&](Mat &frame) { ex.processStaticSaliency(saliencyAlgorithm, frame); };
+	kernels.push_back(k);
+
+	json results = json::array();
+	for (const Kernel &kernel : kernels) {
+		if (!selected(options, kernel.name)) {
+			continue;
+		}
+		for (const Frame &frame : frames) {
+			Mat image = frame.image.clone();			//Kernels take the frame by value or non-const reference
+			kernel.prepare(image);
+			kernel.run(image);							//Warm up: first call loads models, sizes buffers
+
+			vector<double> times;
+			size_t allocations = 0;
+			double elapsedMs = 0;
+			while ((int)times.size() < options.minIterations || elapsedMs < options.minMs) {
+				size_t before = heapAllocations;
+				auto start = chrono::high_resolution_clock::now();
+				kernel.run(image);
+				auto end = chrono::high_resolution_clock::now();
+				allocations += heapAllocations - before;
+				double ns = chrono::duration<double, nano>(end - start).count();
+				times.push_back(ns);
+				elapsedMs += ns / 1e6;
+			}
+
+			sort(times.begin(), times.end());
+			double mean = 0;
+			for (double t : times) {
+				mean += t / times.size();
+			}
+			double median = times[times.size() / 2];
+			double pixels = (double)image.cols * image.rows;
+			json r;
+			r["kernel"] = kernel.name;
+			r["source"] = frame.source;
+			r["width"] = image.cols;
+			r["height"] = image.rows;
+			r["iterations"] = times.size();
+			r["ns_per_frame"] = median;
+			r["ns_mean"] = mean;
+			r["ns_min"] = times.front();
+			r["allocations_per_call"] = (double)allocations / times.size();
+			r["frames_per_sec"] = 1e9 / median;
+			r["megapixels_per_sec"] = pixels / median * 1e3;
+			results.push_back(r);
+			cerr << " [*] " << kernel.name << " " << frame.source << " " << image.cols << "x" << image.rows << ": "
+				<< median / 1e6 << " ms/frame, " << (double)allocations / times.size() << " allocations/call" << endl;
+		}
+	}
+
+	json report;
+	report["benchmark"] = "processing";
+	report["opencv"] = CV_VERSION;
+	report["threads"] = getNumThreads();
+	report["min_ms"] = options.minMs;
+	report["min_iterations"] = options.minIterations;
+	report["seed"] = options.seed;
+	report["allocations_counted"] = "operator new in processing-bench only, not cv::Mat data (fastMalloc) or allocations inside OpenCV DLLs";
+	report["results"] = results;
+
+	if (options.out.empty()) {
+		cout << report.dump(2) << endl;
+		return 0;
+	}
+	ofstream file(options.out);
+	if (!file.is_open()) {
+		cout << " [!] cannot write " << options.out << endl;
+		return 1;
+	}
+	file << report.dump(2) << endl;
+	cerr << " [*] results saved to " << options.out << endl;
+	return 0;
+}
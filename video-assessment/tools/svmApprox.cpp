@@ -0,0 +1,158 @@
+//Agreement and speed of the random Fourier feature approximation against the
+//exact SVM of a model bundle, on a sample set such as *_evaluation_samples.csv.
+//
+//  svm-approx --model <model.yml> --samples <csv> [--normalised]
+//             [--components 128,256,512,1024,2048] [--seed 1] [--repeat 50] [--report <csv>]
+//
+//Run from bin/: the bundle is only accepted while its training files are unchanged.
+
+#include "RffModel.h"
+#include "CsvTable.h"
+#include "mlclass.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+	struct Result
+	{
+		int components;
+		double agreement;
+		double exactUs;				//Per sample
+		double approxUs;
+	};
+
+	void usage()
+	{
+		cout << "usage: svm-approx --model <model.yml> --samples <csv> [--normalised]" << endl
+			<< "                  [--components 128,256,512,1024,2048] [--seed 1] [--repeat 50] [--report <csv>]" << endl;
+	}
+
+	template <typename Predict>
+	double timePerSample(int repeat, int rows, Predict predict)
+	{
+		auto start = chrono::high_resolution_clock::now();
+		for (int i = 0; i < repeat; ++i) {
+			predict();
+		}
+		auto end = chrono::high_resolution_clock::now();
+		return chrono::duration<double, micro>(end - start).count() / ((double)repeat * rows);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	string modelPath, samplesPath, reportPath;
+	string components = "128,256,512,1024,2048";
+	bool normalised = false;
+	unsigned seed = 1;
+	int repeat = 50;
+	for (int i = 1; i < argc; ++i) {
+		string key = argv[i];
+		if (key == "--normalised") {
+			normalised = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			usage();
+			return 1;
+		}
+		const char *value = argv[++i];
+		if (key == "--model") modelPath = value;
+		else if (key == "--samples") samplesPath = value;
+		else if (key == "--components") components = value;
+		else if (key == "--seed") seed = (unsigned)strtoul(value, nullptr, 10);
+		else if (key == "--repeat") repeat = max(1, atoi(value));
+		else if (key == "--report") reportPath = value;
+		else {
+			cout << " [!] unknown option " << key << endl;
+			usage();
+			return 1;
+		}
+	}
+	if (modelPath.empty() || samplesPath.empty()) {
+		usage();
+		return 1;
+	}
+
+	vector< vector<double> > maxmin;
+	Ptr<SVM> svm = mlclass::loadModel(modelPath, 0, maxmin);
+	if (svm.empty()) {
+		cout << " [!] model missing or its training data changed: " << modelPath << endl;
+		return 1;
+	}
+	CsvTable csv;
+	if (!csv.load(samplesPath) || csv.rows() == 0) {
+		cout << " [!] no samples in " << samplesPath << endl;
+		return 1;
+	}
+
+	//Samples through the same normalisation as mlclass::predictBatch
+	int inputs = (int)maxmin[0].size();
+	Mat raw((int)csv.rows(), inputs, CV_32FC1);
+	for (int r = 0; r < raw.rows; ++r) {
+		float *row = raw.ptr<float>(r);
+		for (int j = 0; j < inputs; ++j) {
+			row[j] = (float)csv.get(r, j);
+		}
+	}
+	Mat samples;
+	if (normalised) {
+		samples = raw;
+	}
+	else {
+		vector<float> mins, scales;
+		mlclass::prepareNormalisation(maxmin, mins, scales);
+		mlclass::normaliseSamples(raw, mins, scales, samples);
+	}
+
+	Mat exact;
+	double exactUs = timePerSample(repeat, samples.rows, [&]() { svm->predict(samples, exact); });
+	cout << " [*] " << samples.rows << " samples, " << inputs << " inputs, "
+		<< svm->getSupportVectors().rows << " support vectors, exact " << exactUs << " us/sample" << endl;
+
+	vector<Result> results;
+	stringstream list(components);
+	string item;
+	while (getline(list, item, ',')) {
+		int d = atoi(item.c_str());
+		RffModel rff;
+		if (d <= 0 || !rff.build(svm, d, seed)) {
+			continue;
+		}
+		Mat approx;
+		double approxUs = timePerSample(repeat, samples.rows, [&]() { rff.predict(samples, approx); });
+		int same = 0;
+		for (int r = 0; r < samples.rows; ++r) {
+			if (approx.at<float>(r, 0) == exact.at<float>(r, 0)) same++;
+		}
+		Result result = { d, (double)same / samples.rows, exactUs, approxUs };
+		results.push_back(result);
+		cout << " [*] " << d << " components: agreement " << result.agreement * 100 << "%, "
+			<< approxUs << " us/sample (" << exactUs / approxUs << "x)" << endl;
+	}
+
+	if (!reportPath.empty()) {
+		ofstream file(reportPath);
+		if (!file.is_open()) {
+			cout << " [!] cannot write report " << reportPath << endl;
+			return 1;
+		}
+		file << "# model," << modelPath << "\n";
+		file << "# samples," << samplesPath << "," << samples.rows << ",support_vectors," << svm->getSupportVectors().rows
+			<< ",seed," << seed << ",repeat," << repeat << "\n";
+		file << "components,agreement,exact_us,approx_us,speedup\n";
+		for (const Result &r : results) {
+			file << r.components << "," << r.agreement << "," << r.exactUs << "," << r.approxUs << ","
+				<< r.exactUs / r.approxUs << "\n";
+		}
+		cout << " [*] report saved to " << reportPath << endl;
+	}
+	return results.empty() ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+//Offline trainer for the aesthetic/interest SVMs. Runs a k-fold cross-validated
+//search over C and gamma on all cores and writes a model bundle mlclass loads.
+//
+//  svm-trainer --features <csv> --labels <csv> [--maxmin <csv>] --out <model.yml>
+//              [--report <csv>] [--folds 5] [--search grid|random] [--trials 60]
+//              [--seed 1] [--threads 0] [--c-min 2^-5] [--c-max 2^15]
+//              [--g-min 2^-15] [--g-max 2^3] [--step 2]
+
+#include "SvmTrainer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+	struct Options
+	{
+		mlclass::ModelSource source;
+		string out;
+		string report;
+		string search = "grid";
+		int folds = 5;
+		int trials = 60;
+		unsigned seed = 1;
+		unsigned threads = 0;
+		double cMin = pow(2.0, -5);
+		double cMax = pow(2.0, 15);
+		double gMin = pow(2.0, -15);
+		double gMax = pow(2.0, 3);
+		double step = 2;
+	};
+
+	void usage()
+	{
+		cout << "usage: svm-trainer --features <csv> --labels <csv> [--maxmin <csv>] --out <model.yml>" << endl
+			<< "                   [--report <csv>] [--folds 5] [--search grid|random] [--trials 60]" << endl
+			<< "                   [--seed 1] [--threads 0] [--c-min x] [--c-max x] [--g-min x] [--g-max x] [--step log2]" << endl;
+	}
+
+	bool parseOptions(int argc, char **argv, Options &options)
+	{
+		options.source.C = 0;
+		options.source.G = 0;
+		for (int i = 1; i < argc; ++i) {
+			string key = argv[i];
+			if (i + 1 >= argc) {
+				cout << " [!] missing value for " << key << endl;
+				return false;
+			}
+			const char *value = argv[++i];
+			if (key == "--features") options.source.featureVector = value;
+			else if (key == "--labels") options.source.binaryScores = value;
+			else if (key == "--maxmin") options.source.maxminPath = value;
+			else if (key == "--out") options.out = value;
+			else if (key == "--report") options.report = value;
+			else if (key == "--search") options.search = value;
+			else if (key == "--folds") options.folds = atoi(value);
+			else if (key == "--trials") options.trials = atoi(value);
+			else if (key == "--seed") options.seed = (unsigned)strtoul(value, nullptr, 10);
+			else if (key == "--threads") options.threads = (unsigned)strtoul(value, nullptr, 10);
+			else if (key == "--c-min") options.cMin = atof(value);
+			else if (key == "--c-max") options.cMax = atof(value);
+			else if (key == "--g-min") options.gMin = atof(value);
+			else if (key == "--g-max") options.gMax = atof(value);
+			else if (key == "--step") options.step = atof(value);
+			else {
+				cout << " [!] unknown option " << key << endl;
+				return false;
+			}
+		}
+		if (options.source.featureVector.empty() || options.source.binaryScores.empty() || options.out.empty()) {
+			return false;
+		}
+		if (options.search != "grid" && options.search != "random") {
+			cout << " [!] --search must be grid or random" << endl;
+			return false;
+		}
+		if (options.cMin <= 0 || options.gMin <= 0 || options.cMax < options.cMin || options.gMax < options.gMin) {
+			cout << " [!] C and gamma ranges must be positive" << endl;
+			return false;
+		}
+		return true;
+	}
+
+	//Best first; ties go to the smaller C then smaller gamma (smoother model)
+	bool better(const SvmTrainer::Candidate &a, const SvmTrainer::Candidate &b)
+	{
+		if (a.correct != b.correct) return a.correct > b.correct;
+		if (a.C != b.C) return a.C < b.C;
+		return a.G < b.G;
+	}
+
+	bool writeReport(const Options &options, const SvmTrainer &trainer, unsigned threads,
+		const vector<SvmTrainer::Candidate> &candidates, double searchMs, double finalMs)
+	{
+		ofstream file(options.report);
+		if (!file.is_open()) {
+			cout << " [!] cannot write report " << options.report << endl;
+			return false;
+		}
+		file.precision(10);
+		file << "# features," << options.source.featureVector << "\n";
+		file << "# labels," << options.source.binaryScores << "\n";
+		file << "# maxmin," << options.source.maxminPath << "\n";
+		file << "# samples," << trainer.samples() << ",inputs," << trainer.features()
+			<< ",folds," << options.folds << ",search," << options.search << ",seed," << options.seed
+			<< ",threads," << threads << "\n";
+		file << "# search_ms," << searchMs << ",final_train_ms," << finalMs << "\n";
+		file << "C,gamma,accuracy,correct,train_ms\n";
+		for (const SvmTrainer::Candidate &c : candidates) {
+			file << c.C << "," << c.G << "," << c.accuracy << "," << c.correct << "," << c.trainMs << "\n";
+		}
+		return true;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		usage();
+		return 1;
+	}
+
+	SvmTrainer trainer;
+	if (!trainer.load(options.source)) {
+		return 1;
+	}
+	ThreadPool pool(options.threads);
+	unsigned threads = options.threads ? options.threads : max(1u, thread::hardware_concurrency());
+	cout << " [*] " << trainer.samples() << " samples, " << trainer.features() << " inputs, "
+		<< options.folds << " folds, " << threads << " threads" << endl;
+
+	vector<SvmTrainer::Candidate> candidates = options.search == "grid"
+		? SvmTrainer::gridCandidates(options.cMin, options.cMax, options.gMin, options.gMax, options.step)
+		: SvmTrainer::randomCandidates(options.cMin, options.cMax, options.gMin, options.gMax, options.trials, options.seed);
+	if (candidates.empty()) {
+		cout << " [!] no candidates to search" << endl;
+		return 1;
+	}
+
+	auto start = chrono::high_resolution_clock::now();
+	if (!trainer.crossValidate(candidates, options.folds, options.seed, pool)) {
+		return 1;
+	}
+	auto searched = chrono::high_resolution_clock::now();
+	sort(candidates.begin(), candidates.end(), better);
+	const SvmTrainer::Candidate &best = candidates.front();
+
+	Ptr<SVM> s = trainer.train(best.C, best.G);
+	auto trained = chrono::high_resolution_clock::now();
+	double searchMs = chrono::duration<double, milli>(searched - start).count();
+	double finalMs = chrono::duration<double, milli>(trained - searched).count();
+
+	cout << " [*] " << candidates.size() << " candidates in " << searchMs << " ms" << endl;
+	cout << " [*] best C=" << best.C << " gamma=" << best.G << " accuracy=" << best.accuracy << endl;
+
+	options.source.C = best.C;
+	options.source.G = best.G;
+	if (!mlclass::saveModel(options.out, options.source, s, trainer.maxmin())) {
+		cout << " [!] model not saved: " << options.out << endl;
+		return 1;
+	}
+	cout << " [*] model saved to " << options.out << endl;
+
+	if (!options.report.empty() && writeReport(options, trainer, threads, candidates, searchMs, finalMs)) {
+		cout << " [*] report saved to " << options.report << endl;
+	}
+	return 0;
+}
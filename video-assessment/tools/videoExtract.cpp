@@ -0,0 +1,174 @@
+//Headless feature extraction, the same outputs the gallery writes before its
+//first start: output.csv, semantic_data.csv, audio_result.csv and thumbnails.
+//No openFrameworks and no GL context, so it runs on render nodes and in batch
+//jobs. Relative paths (models, cascades, templates) are read from the working
+//directory, like the gallery does from bin/.
+//
+//  video-extract [--config data/extractor_config.xml] [--out data/output/output.csv]
+//                [--semantic data/output/semantic_data.csv] [--audio data/audio/audio_result.csv]
+//                [--thumbnails data/thumbnails/videos/] [folder|file]...
+//
+//Folders are listed like the gallery lists data/files; files get IDs 1..n in
+//argument order. Without inputs the config INPUT_FOLDER is extracted.
+
+#include "extractor.h"
+#include "mlclass.h"
+#include "FeatureSchema.h"
+#include "XmlFieldReader.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+
+	struct Options
+	{
+		string config = "data/extractor_config.xml";
+		string out = "data/output/output.csv";
+		string semantic = "data/output/semantic_data.csv";
+		string audio = "data/audio/audio_result.csv";
+		string thumbnails;						//Empty = extractor default
+		vector<string> inputs;
+	};
+
+	void usage()
+	{
+		cout << "usage: video-extract [--config <xml>] [--out <csv>] [--semantic <csv>] [--audio <csv>]" << endl
+			<< "                     [--thumbnails <folder>] [folder|file]..." << endl;
+	}
+
+	bool parseOptions(int argc, char **argv, Options &options)
+	{
+		for (int i = 1; i < argc; ++i) {
+			string key = argv[i];
+			if (key.compare(0, 2, "--") != 0) {
+				options.inputs.push_back(key);
+				continue;
+			}
+			if (i + 1 >= argc) {
+				cout << " [!] missing value for " << key << endl;
+				return false;
+			}
+			const char *value = argv[++i];
+			if (key == "--config") options.config = value;
+			else if (key == "--out") options.out = value;
+			else if (key == "--semantic") options.semantic = value;
+			else if (key == "--audio") options.audio = value;
+			else if (key == "--thumbnails") options.thumbnails = value;
+			else {
+				cout << " [!] unknown option " << key << endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool isFolder(const string &path)
+	{
+		struct stat buffer;
+		return stat(path.c_str(), &buffer) == 0 && (buffer.st_mode & S_IFDIR) != 0;
+	}
+
+	//Folder contents sorted, files as given
+	bool listInputs(const vector<string> &inputs, vector<string> &files)
+	{
+		for (const string &input : inputs) {
+			if (isFolder(input)) {
+				vector<String> listed;
+				glob(input, listed);
+				files.insert(files.end(), listed.begin(), listed.end());
+			}
+			else {
+				ifstream file(input);
+				if (!file) {
+					cout << " [!] input not found: " << input << endl;
+					return false;
+				}
+				files.push_back(input);
+			}
+		}
+		return true;
+	}
+
+}
+
+int main(int argc, char **argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		usage();
+		return 1;
+	}
+	if (options.inputs.empty()) {
+		XmlFieldReader config;
+		if (!config.load(options.config) || config.getString("INPUT_FOLDER").empty()) {
+			cout << " [!] no inputs, and no INPUT_FOLDER in " << options.config << endl;
+			usage();
+			return 1;
+		}
+		options.inputs.push_back(config.getString("INPUT_FOLDER"));
+	}
+
+	vector<string> files;
+	if (!listInputs(options.inputs, files)) {
+		return 1;
+	}
+	cout << " [!] number of files to process: " << files.size() << "\n\n";
+
+	ofstream featureFile(options.out);
+	ofstream semanticFile(options.semantic);
+	ofstream audioFile(options.audio);
+	if (!featureFile.is_open() || !semanticFile.is_open() || !audioFile.is_open()) {
+		cout << " [!] cannot write " << options.out << ", " << options.semantic << " or " << options.audio << endl;
+		return 1;
+	}
+
+	extractor ex;
+	mlclass mlc;
+	ex.configPath = options.config;
+	if (!options.thumbnails.empty()) {
+		extractor::thumbnailFolderPath = options.thumbnails;
+	}
+	mlc.init();
+	ex.init();
+
+	//Row per file in all three files, written and flushed as each file is done
+	size_t invalid = 0;
+	for (size_t nv = 0; nv < files.size(); ++nv) {
+		auto start = chrono::high_resolution_clock::now();
+		ex.extractFromVideo(files[nv], (int)nv + 1);
+
+		vector<pair<double, int> > semantic = ex.getSemanticMap();
+		semanticFile << formatSemanticRow(semantic) << "\n";
+		semanticFile.flush();
+
+		vector<double> audio = ex.getAudioMap();
+		if (!audio.empty()) {						//No line when audio is not extracted
+			audioFile << formatAudioRow(audio) << "\n";
+			audioFile.flush();
+		}
+
+		FeatureRecord features = ex.getFeatures();
+		features[FEAT_AESTHETIC] = mlc.predictSample(features, 0);
+		features[FEAT_INTEREST] = mlc.predictSample(features, 1);
+		if (!features.isFinite()) {
+			invalid++;
+		}
+		featureFile << formatCsvRow((int)nv + 1, features) << "\n";
+		featureFile.flush();
+
+		auto end = chrono::high_resolution_clock::now();
+		cout << " [!] File " << files[nv] << " processed in : "
+			<< chrono::duration_cast<chrono::milliseconds>(end - start).count() << " ms\n" << endl;
+	}
+
+	if (invalid > 0) {
+		cout << " [!] " << invalid << " files with invalid feature values (null in " << options.out << ")" << endl;
+	}
+	cout << " [*] " << files.size() << " files extracted to " << options.out << endl;
+	return 0;
+}